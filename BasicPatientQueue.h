@@ -0,0 +1,833 @@
+/*
+ * BasicPatientQueue.h
+ *
+ * This file declares and implements the BasicPatientQueue class template,
+ * a d-ary min-heap of patients whose storage, tie-break rule, arity and
+ * name index are chosen at compile time:
+ *
+ *   Storage - random access container with push_back(), pop_back() and
+ *             back(), such as std::vector or std::deque, either of
+ *             PatientEntry, which holds the name, or of PatientKey,
+ *             which leaves the name in a table of the queue
+ *   Compare - rule for patients of equal priority, ByName or ByArrival
+ *   Arity   - number of children of every heap node, at least 2
+ *   Index   - NoIndex, or NameIndex to find the slots of a name
+ *             without searching the whole heap
+ *
+ * The class is final, so code that holds the concrete type instead of a
+ * PatientQueue reference calls the members directly and the compiler can
+ * inline them into hot loops; it still works through PatientQueue too.
+ * HeapPatientQueue and DaryHeapPatientQueue are instantiations of it.
+ */
+
+#ifndef _basicpatientqueue_h
+#define _basicpatientqueue_h
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "patientqueue.h"
+
+/*
+ * One patient in the heap. The timestamp is the order of arrival,
+ * renewed by upgradePatient().
+ */
+struct PatientEntry {
+    std::string name;
+    int priority;
+    int timestamp;
+};
+
+/*
+ * One patient in a heap that keeps the names apart, so sifting reads
+ * 16 bytes per patient. The rank comes from the tie-break policy and
+ * orders most patients of equal priority without reading their names.
+ */
+struct PatientKey {
+    uint64_t rank;
+    int priority;
+    int id; // index of the name in the NameTable of the queue
+};
+
+/*
+ * Names of a heap of PatientKey by id, ids of patients who left are reused.
+ */
+struct NameTable {
+    std::vector<std::string> names;
+    std::vector<int> freeIds;
+};
+
+/*
+ * Tie-break policies: before() returns true if the first patient is more
+ * urgent. rank() returns the rank of a key, and keys with equal priorities
+ * and ranks are ordered by the names in the table.
+ */
+struct ByName {
+    // by priority, then by name
+    static bool before(const PatientEntry& e1, const PatientEntry& e2) {
+        if (e1.priority != e2.priority)
+            return e1.priority < e2.priority;
+        return e1.name < e2.name;
+    }
+
+    static bool before(const PatientKey& k1, const PatientKey& k2, const NameTable& table) {
+        if (k1.priority != k2.priority)
+            return k1.priority < k2.priority;
+        if (k1.rank != k2.rank)
+            return k1.rank < k2.rank;
+        return table.names[k1.id] < table.names[k2.id];
+    }
+
+    // the first 8 bytes of the name, padded with zeros, so ranks order
+    // names like comparing the strings does, except for names that share them
+    static uint64_t rank(const std::string& name, int) {
+        uint64_t rank = 0;
+        for (size_t i = 0; i < 8; ++i) {
+            unsigned char ch = i < name.size() ? name[i] : 0;
+            rank = (rank << 8) | ch;
+        }
+        return rank;
+    }
+};
+
+struct ByArrival {
+    // by priority, then by order of arrival, like LinkedListPatientQueue
+    static bool before(const PatientEntry& e1, const PatientEntry& e2) {
+        if (e1.priority != e2.priority)
+            return e1.priority < e2.priority;
+        return e1.timestamp < e2.timestamp;
+    }
+
+    static bool before(const PatientKey& k1, const PatientKey& k2, const NameTable&) {
+        if (k1.priority != k2.priority)
+            return k1.priority < k2.priority;
+        return k1.rank < k2.rank;
+    }
+
+    // timestamps are never equal, so the names are never read
+    static uint64_t rank(const std::string&, int timestamp) {
+        return timestamp;
+    }
+};
+
+/*
+ * Name index policies. While an index is active, the queue tells it every
+ * heap slot a patient takes or leaves; find() returns the slots of a name,
+ * or nullptr if there are none. A queue that does not use its index
+ * searches the whole heap for a name.
+ */
+struct NoIndex {
+    bool used() const { return false; }
+    bool active() const { return false; }
+    const std::vector<int>* find(const std::string&) const { return nullptr; }
+    void added(const std::string&, int) {}
+    void moved(const std::string&, int, int) {}
+    void removed(const std::string&, int) {}
+    void clear() {}
+    void invalidate() {}
+};
+
+class NameIndex {
+public:
+    // Converts from bool, so HeapPatientQueue(true) is an indexed queue
+    // and HeapPatientQueue() one that searches
+    NameIndex(bool used = false) : inUse(used), upToDate(used) {}
+
+    bool used() const { return inUse; }
+    bool active() const { return upToDate; }
+
+    const std::vector<int>* find(const std::string& name) const {
+        auto iter = slots.find(name);
+        return iter == slots.end() ? nullptr : &iter->second;
+    }
+
+    void added(const std::string& name, int slot) {
+        slots[name].push_back(slot);
+    }
+
+    void moved(const std::string& name, int from, int to) {
+        for (int& slot: slots[name]) {
+            if (slot == from) {
+                slot = to;
+                return;
+            }
+        }
+    }
+
+    void removed(const std::string& name, int slot) {
+        auto iter = slots.find(name);
+        if (iter == slots.end())
+            return;
+
+        std::vector<int>& named = iter->second;
+        for (size_t i = 0; i < named.size(); ++i) {
+            if (named[i] == slot) {
+                named[i] = named.back();
+                named.pop_back();
+                break;
+            }
+        }
+
+        if (named.empty())
+            slots.erase(iter);
+    }
+
+    // an empty index is up to date
+    void clear() {
+        slots.clear();
+        upToDate = inUse;
+    }
+
+    // the queue rebuilds it when it needs it
+    void invalidate() {
+        slots.clear();
+        upToDate = false;
+    }
+
+private:
+    bool inUse;
+    bool upToDate;
+    // patient name -> heap slots holding that name
+    std::unordered_map<std::string, std::vector<int>> slots;
+};
+
+template <typename Storage, typename Compare = ByName, int Arity = 2, typename Index = NoIndex>
+class BasicPatientQueue final : public PatientQueue {
+    static_assert(Arity >= 2, "BasicPatientQueue: arity must be at least 2.");
+
+public:
+    explicit BasicPatientQueue(Index index = Index());
+    std::string frontName();
+    void clear();
+    int frontPriority();
+    bool isEmpty();
+    void newPatient(std::string name, int priority);
+    void newPatients(const Vector<PatientRecord>& patients);
+    std::string processPatient();
+    Vector<std::string> processPatients(int k);
+    Vector<PatientRecord> peekTop(int k);
+    void upgradePatient(std::string name, int newPriority);
+    void removePatient(std::string name);
+    std::string toString();
+
+    // Appends the heap array to out in a compact binary form:
+    // count, then (priority, name length) of every slot, then all names.
+    // Numbers are in the byte order of the machine. Only queues ordered
+    // by name can be stored, as the order of arrival is not.
+    void writeSnapshot(std::string& out);
+
+    // Replaces the queue with the heap array stored by writeSnapshot().
+    // The array is sifted into a heap in linear time, which moves nothing
+    // when the snapshot is intact, and the name index is built only when
+    // an upgrade or removal needs it.
+    // Throws string exception if the data is not a valid snapshot.
+    void readSnapshot(const char* data, size_t size);
+
+private:
+    typedef typename Storage::value_type Entry;
+
+    Storage heap;    // root is heap[0]
+    NameTable table; // names of a heap of keys, not used by a heap of entries
+    Index index;
+    int timestamp;
+
+    // where the name of a patient lives depends on the entry type
+    void assign(PatientEntry& entry, std::string name, int priority);
+    void assign(PatientKey& key, std::string name, int priority);
+    const std::string& nameOf(const PatientEntry& entry) const;
+    const std::string& nameOf(const PatientKey& key) const;
+    std::string takeName(PatientEntry& entry);
+    std::string takeName(PatientKey& key);
+    void renew(PatientEntry& entry);
+    void renew(PatientKey& key);
+    bool before(const PatientEntry& e1, const PatientEntry& e2);
+    bool before(const PatientKey& k1, const PatientKey& k2);
+
+    template <typename T>
+    void reserve(std::vector<T>& storage, size_t size);
+    template <typename Other>
+    void reserve(Other&, size_t) {}
+
+    void add(std::string name, int priority);
+    std::string takeOut(int slot);
+    void moveUp(int slot);
+    void moveDown(int slot);
+    int findName(const std::string& name);
+    void buildIndex();
+};
+
+/*
+ * Queues for the common cases.
+ */
+typedef BasicPatientQueue<std::vector<PatientEntry>, ByName> NameOrderedPatientQueue;
+typedef BasicPatientQueue<std::vector<PatientEntry>, ByArrival, 4> ArrivalOrderedPatientQueue;
+
+// Constructor. Creates empty queue
+template <typename Storage, typename Compare, int Arity, typename Index>
+BasicPatientQueue<Storage, Compare, Arity, Index>::BasicPatientQueue(Index index)
+    : index(std::move(index)), timestamp(0)
+{
+}
+
+// Removes all elements from the patient queue
+template <typename Storage, typename Compare, int Arity, typename Index>
+void BasicPatientQueue<Storage, Compare, Arity, Index>::clear()
+{
+    STATS_TIME(CLEAR);
+    heap.clear();
+    table.names.clear();
+    table.freeIds.clear();
+    index.clear();
+    timestamp = 0;
+}
+
+// Returns the name of the most urgent patient.
+// Throws string exception if the queue does not contain any patients.
+template <typename Storage, typename Compare, int Arity, typename Index>
+std::string BasicPatientQueue<Storage, Compare, Arity, Index>::frontName()
+{
+    STATS_TIME(FRONT_NAME);
+    if (heap.empty())
+        throw frontNameExceptStr();
+    return nameOf(heap[0]);
+}
+
+// Returns the integer priority of the most urgent patient
+// Throws string exception if the queue does not contain any patients.
+template <typename Storage, typename Compare, int Arity, typename Index>
+int BasicPatientQueue<Storage, Compare, Arity, Index>::frontPriority()
+{
+    STATS_TIME(FRONT_PRIORITY);
+    if (heap.empty())
+        throw frontPriorityExceptStr();
+    return heap[0].priority;
+}
+
+// Returns true if your patient queue does not contain any elements
+// and false if it does contain at least one patient.
+template <typename Storage, typename Compare, int Arity, typename Index>
+bool BasicPatientQueue<Storage, Compare, Arity, Index>::isEmpty()
+{
+    return heap.empty();
+}
+
+// Adds the given person into the patient queue with the given priority.
+template <typename Storage, typename Compare, int Arity, typename Index>
+void BasicPatientQueue<Storage, Compare, Arity, Index>::newPatient(std::string name, int priority)
+{
+    STATS_TIME(NEW_PATIENT);
+    STATS_DEPTH(heap.size());
+
+    add(std::move(name), priority);
+
+    moveUp(heap.size() - 1); // find appropriate position
+}
+
+// Adds all given patients.
+// Reserves space once, then sifts each patient up,
+// or rebuilds the heap bottom-up if the batch is at least as big as the heap.
+template <typename Storage, typename Compare, int Arity, typename Index>
+void BasicPatientQueue<Storage, Compare, Arity, Index>::newPatients(const Vector<PatientRecord>& patients)
+{
+    STATS_TIME(NEW_PATIENTS);
+    if (patients.isEmpty())
+        return;
+
+    int first = heap.size();
+    reserve(heap, heap.size() + patients.size());
+
+    for (const auto &patient: patients)
+    {
+        STATS_DEPTH(heap.size());
+        add(patient.name, patient.priority);
+    }
+
+    int size = heap.size();
+    if (patients.size() < first)
+    {
+        for (int i = first; i < size; ++i)
+            moveUp(i);
+    }
+    else
+    {
+        // Floyd's method: sift down every parent, starting from the last one
+        for (int i = (size - 2) / Arity; i >= 0; --i)
+            moveDown(i);
+    }
+}
+
+// Removes the patient with the most urgent priority from the queue,
+// and you returns their name as a string.
+// Throws string exception if the queue does not contain any patients.
+template <typename Storage, typename Compare, int Arity, typename Index>
+std::string BasicPatientQueue<Storage, Compare, Arity, Index>::processPatient()
+{
+    STATS_TIME(PROCESS_PATIENT);
+    if (heap.empty())
+        throw processPatientExceptStr();
+
+    return takeOut(0);
+}
+
+// Removes up to k most urgent patients and returns their names in order.
+// Taking the whole heap sorts it once instead of sifting down for every patient.
+template <typename Storage, typename Compare, int Arity, typename Index>
+Vector<std::string> BasicPatientQueue<Storage, Compare, Arity, Index>::processPatients(int k)
+{
+    STATS_TIME(PROCESS_PATIENTS);
+    Vector<std::string> processed;
+
+    if (k >= static_cast<int>(heap.size()))
+    {
+        std::sort(heap.begin(), heap.end(),
+                  [this](const Entry& e1, const Entry& e2) { return before(e1, e2); });
+
+        for (auto &entry: heap)
+        {
+            processed.add(std::string());
+            processed[processed.size() - 1] = takeName(entry);
+        }
+
+        clear();
+        return processed;
+    }
+
+    for (int i = 0; i < k; ++i)
+    {
+        processed.add(std::string());
+        processed[processed.size() - 1] = processPatient();
+    }
+
+    return processed;
+}
+
+// Returns up to k most urgent patients without changing the heap.
+// Walks the heap from the root, keeping the slots that may come next
+// in a small heap of their own, so only about k * Arity slots are visited.
+template <typename Storage, typename Compare, int Arity, typename Index>
+Vector<PatientRecord> BasicPatientQueue<Storage, Compare, Arity, Index>::peekTop(int k)
+{
+    STATS_TIME(PEEK_TOP);
+    Vector<PatientRecord> top;
+    if (k <= 0 || heap.empty())
+        return top;
+
+    int size = heap.size();
+    auto later = [this](int s1, int s2) { return before(heap[s2], heap[s1]); };
+    std::vector<int> frontier(1, 0);
+
+    while (!frontier.empty() && top.size() < k)
+    {
+        std::pop_heap(frontier.begin(), frontier.end(), later);
+        int slot = frontier.back();
+        frontier.pop_back();
+
+        PatientRecord patient;
+        patient.name = nameOf(heap[slot]);
+        patient.priority = heap[slot].priority;
+        top.add(patient);
+
+        int first = slot * Arity + 1; // first child
+        for (int child = first; child < first + Arity && child < size; ++child)
+        {
+            frontier.push_back(child);
+            std::push_heap(frontier.begin(), frontier.end(), later);
+        }
+    }
+
+    return top;
+}
+
+// Modifies the priority of a given existing patient in the queue.
+// The patient is treated as a new arrival at the new priority.
+// Throws string exception if the given patient is present in the queue and already
+// has a more urgent priority than the given new priority.
+// Throws string exception if the given patient is not already in the queue
+template <typename Storage, typename Compare, int Arity, typename Index>
+void BasicPatientQueue<Storage, Compare, Arity, Index>::upgradePatient(std::string name, int newPriority)
+{
+    STATS_TIME(UPGRADE_PATIENT);
+    int found = findName(name);
+    STATS_SEARCH(index.used() ? 1 : heap.size()); // one index lookup, or every slot
+
+    if (found < 0)
+        throw upgradeNoPatientExceptStr(name, newPriority);
+
+    if (heap[found].priority <= newPriority)
+        throw upgradeWrongPriorityExceptStr(name, newPriority, heap[found].priority);
+
+    heap[found].priority = newPriority;
+    renew(heap[found]);
+
+    moveUp(found); // find appropriate position
+}
+
+// Removes the most urgent patient with the given name from the queue.
+// Throws string exception if the given patient is not in the queue
+template <typename Storage, typename Compare, int Arity, typename Index>
+void BasicPatientQueue<Storage, Compare, Arity, Index>::removePatient(std::string name)
+{
+    STATS_TIME(REMOVE_PATIENT);
+    int found = findName(name);
+    STATS_SEARCH(index.used() ? 1 : heap.size());
+
+    if (found < 0)
+        throw removeNoPatientExceptStr(name);
+
+    takeOut(found);
+}
+
+// Returns string representation of the queue
+// in the form of "{priority1:value1, priority2:value2}"
+template <typename Storage, typename Compare, int Arity, typename Index>
+std::string BasicPatientQueue<Storage, Compare, Arity, Index>::toString()
+{
+    STATS_TIME(TO_STRING);
+    if (heap.empty())
+        return "{}";
+
+    std::stringstream str;
+
+    str << "{" << heap[0].priority << ":" << nameOf(heap[0]);
+
+    for (size_t i = 1; i < heap.size(); ++i)
+    {
+        str << ", " << heap[i].priority << ":" << nameOf(heap[i]);
+    }
+    str << "}";
+
+    return str.str();
+}
+
+// Appends the heap array to out in the format read by readSnapshot()
+template <typename Storage, typename Compare, int Arity, typename Index>
+void BasicPatientQueue<Storage, Compare, Arity, Index>::writeSnapshot(std::string& out)
+{
+    static_assert(std::is_same<Compare, ByName>::value,
+                  "BasicPatientQueue: only queues ordered by name have snapshots.");
+
+    uint32_t size = heap.size();
+    out.append(reinterpret_cast<const char *>(&size), sizeof(size));
+
+    for (const auto &entry: heap)
+    {
+        int32_t priority = entry.priority;
+        uint32_t length = nameOf(entry).size();
+        out.append(reinterpret_cast<const char *>(&priority), sizeof(priority));
+        out.append(reinterpret_cast<const char *>(&length), sizeof(length));
+    }
+
+    for (const auto &entry: heap)
+        out.append(nameOf(entry));
+}
+
+// Replaces the queue with the heap array stored by writeSnapshot()
+// Throws string exception if the data is not a valid snapshot.
+template <typename Storage, typename Compare, int Arity, typename Index>
+void BasicPatientQueue<Storage, Compare, Arity, Index>::readSnapshot(const char* data, size_t size)
+{
+    static_assert(std::is_same<Compare, ByName>::value,
+                  "BasicPatientQueue: only queues ordered by name have snapshots.");
+    const size_t SLOT = sizeof(int32_t) + sizeof(uint32_t);
+
+    uint32_t slots;
+    if (size < sizeof(slots))
+        throw std::string("BasicPatientQueue: snapshot is damaged.");
+    memcpy(&slots, data, sizeof(slots));
+
+    if (slots > (size - sizeof(slots)) / SLOT)
+        throw std::string("BasicPatientQueue: snapshot is damaged.");
+
+    const char *slot = data + sizeof(slots);
+    const char *name = slot + static_cast<size_t>(slots) * SLOT;
+    const char *end = data + size;
+
+    clear();
+    // building the index takes much longer than loading the array,
+    // so it is left until an upgrade or removal needs it
+    index.invalidate();
+    reserve(heap, slots);
+
+    for (uint32_t i = 0; i < slots; ++i, slot += SLOT)
+    {
+        int32_t priority;
+        uint32_t length;
+        memcpy(&priority, slot, sizeof(priority));
+        memcpy(&length, slot + sizeof(priority), sizeof(length));
+
+        if (length > static_cast<size_t>(end - name))
+        {
+            clear();
+            throw std::string("BasicPatientQueue: snapshot is damaged.");
+        }
+
+        add(std::string(name, length), priority);
+        name += length;
+    }
+
+    // a damaged snapshot may hold any array: Floyd's method makes it a heap,
+    // and only compares each parent with its children when it already is one
+    // (an empty heap has no parent, though (0 - 2) / Arity rounds to 0)
+    if (heap.size() > 1)
+    {
+        for (int i = (static_cast<int>(heap.size()) - 2) / Arity; i >= 0; --i)
+            moveDown(i);
+    }
+}
+
+// fill an entry that holds the name
+template <typename Storage, typename Compare, int Arity, typename Index>
+void BasicPatientQueue<Storage, Compare, Arity, Index>::assign(PatientEntry& entry, std::string name, int priority)
+{
+    entry.name = std::move(name);
+    entry.priority = priority;
+    entry.timestamp = timestamp++;
+}
+
+// fill a key, storing the name in the table
+template <typename Storage, typename Compare, int Arity, typename Index>
+void BasicPatientQueue<Storage, Compare, Arity, Index>::assign(PatientKey& key, std::string name, int priority)
+{
+    key.priority = priority;
+    key.rank = Compare::rank(name, timestamp++);
+
+    if (table.freeIds.empty())
+    {
+        key.id = table.names.size();
+        STATS_GROWTH(table.names, table.names.push_back(std::move(name)));
+    }
+    else
+    {
+        key.id = table.freeIds.back();
+        table.freeIds.pop_back();
+        table.names[key.id] = std::move(name);
+    }
+}
+
+template <typename Storage, typename Compare, int Arity, typename Index>
+const std::string& BasicPatientQueue<Storage, Compare, Arity, Index>::nameOf(const PatientEntry& entry) const
+{
+    return entry.name;
+}
+
+template <typename Storage, typename Compare, int Arity, typename Index>
+const std::string& BasicPatientQueue<Storage, Compare, Arity, Index>::nameOf(const PatientKey& key) const
+{
+    return table.names[key.id];
+}
+
+// move the name out, the entry is not used anymore
+template <typename Storage, typename Compare, int Arity, typename Index>
+std::string BasicPatientQueue<Storage, Compare, Arity, Index>::takeName(PatientEntry& entry)
+{
+    return std::move(entry.name);
+}
+
+// move the name out of the table and make its id available
+template <typename Storage, typename Compare, int Arity, typename Index>
+std::string BasicPatientQueue<Storage, Compare, Arity, Index>::takeName(PatientKey& key)
+{
+    std::string name = std::move(table.names[key.id]);
+    table.names[key.id].clear();
+    table.freeIds.push_back(key.id);
+    return name;
+}
+
+// the patient arrives again, after an upgrade
+template <typename Storage, typename Compare, int Arity, typename Index>
+void BasicPatientQueue<Storage, Compare, Arity, Index>::renew(PatientEntry& entry)
+{
+    entry.timestamp = timestamp++;
+}
+
+template <typename Storage, typename Compare, int Arity, typename Index>
+void BasicPatientQueue<Storage, Compare, Arity, Index>::renew(PatientKey& key)
+{
+    key.rank = Compare::rank(table.names[key.id], timestamp++);
+}
+
+// compare two entries with the tie-break policy
+template <typename Storage, typename Compare, int Arity, typename Index>
+bool BasicPatientQueue<Storage, Compare, Arity, Index>::before(const PatientEntry& e1, const PatientEntry& e2)
+{
+    STATS_COMPARE();
+    return Compare::before(e1, e2);
+}
+
+// compare two keys with the tie-break policy, which reads the names
+// only when priorities and ranks are equal
+template <typename Storage, typename Compare, int Arity, typename Index>
+bool BasicPatientQueue<Storage, Compare, Arity, Index>::before(const PatientKey& k1, const PatientKey& k2)
+{
+    STATS_COMPARE();
+    return Compare::before(k1, k2, table);
+}
+
+// reserve room for size entries, if the storage can
+template <typename Storage, typename Compare, int Arity, typename Index>
+template <typename T>
+void BasicPatientQueue<Storage, Compare, Arity, Index>::reserve(std::vector<T>& storage, size_t size)
+{
+    STATS_GROWTH(storage, storage.reserve(size));
+}
+
+// append a patient to the heap array, without sifting it up
+template <typename Storage, typename Compare, int Arity, typename Index>
+void BasicPatientQueue<Storage, Compare, Arity, Index>::add(std::string name, int priority)
+{
+    Entry entry;
+    assign(entry, std::move(name), priority);
+    STATS_GROWTH(heap, heap.push_back(std::move(entry)));
+
+    if (index.active())
+        index.added(nameOf(heap.back()), heap.size() - 1);
+}
+
+// take the patient out of the given slot and return their name;
+// the last entry takes the place of the slot,
+// then moves up or down to where it belongs
+template <typename Storage, typename Compare, int Arity, typename Index>
+std::string BasicPatientQueue<Storage, Compare, Arity, Index>::takeOut(int slot)
+{
+    if (index.active())
+        index.removed(nameOf(heap[slot]), slot);
+    std::string name = takeName(heap[slot]);
+
+    int last = heap.size() - 1;
+    if (slot != last)
+    {
+        if (index.active())
+            index.moved(nameOf(heap[last]), last, slot);
+        heap[slot] = std::move(heap[last]);
+        STATS_MOVE();
+    }
+    heap.pop_back();
+
+    if (slot < last)
+    {
+        moveUp(slot);
+        moveDown(slot);
+    }
+
+    return name;
+}
+
+// move entry up on the tree:
+// parents are shifted down into the hole until the entry's place is found
+template <typename Storage, typename Compare, int Arity, typename Index>
+void BasicPatientQueue<Storage, Compare, Arity, Index>::moveUp(int slot)
+{
+    int start = slot;
+    Entry entry = std::move(heap[slot]);
+
+    while (slot > 0)
+    {
+        int parent = (slot - 1) / Arity;
+        if (!before(entry, heap[parent]))
+            break;
+
+        if (index.active())
+            index.moved(nameOf(heap[parent]), parent, slot);
+        heap[slot] = std::move(heap[parent]);
+        STATS_MOVE();
+        slot = parent;
+    }
+
+    if (index.active() && slot != start)
+        index.moved(nameOf(entry), start, slot);
+    heap[slot] = std::move(entry);
+}
+
+// move entry down on the tree:
+// the most urgent child is shifted up into the hole until the entry's place is found
+template <typename Storage, typename Compare, int Arity, typename Index>
+void BasicPatientQueue<Storage, Compare, Arity, Index>::moveDown(int slot)
+{
+    int start = slot;
+    int size = heap.size();
+    Entry entry = std::move(heap[slot]);
+
+    while (true)
+    {
+        int first = slot * Arity + 1; // first child
+        if (first >= size)
+            break;
+
+        int last = first + Arity; // one past the last child
+        if (last > size)
+            last = size;
+
+        // the children are next to each other, so this loop
+        // scans a single run of memory
+        int urgent = first;
+        for (int child = first + 1; child < last; ++child)
+        {
+            if (before(heap[child], heap[urgent]))
+                urgent = child;
+        }
+
+        if (!before(heap[urgent], entry))
+            break;
+
+        if (index.active())
+            index.moved(nameOf(heap[urgent]), urgent, slot);
+        heap[slot] = std::move(heap[urgent]);
+        STATS_MOVE();
+        slot = urgent;
+    }
+
+    if (index.active() && slot != start)
+        index.moved(nameOf(entry), start, slot);
+    heap[slot] = std::move(entry);
+}
+
+// Returns heap slot of the most urgent patient with given name or -1 if not found
+template <typename Storage, typename Compare, int Arity, typename Index>
+int BasicPatientQueue<Storage, Compare, Arity, Index>::findName(const std::string& name)
+{
+    int found = -1;
+
+    if (index.used())
+    {
+        if (!index.active())
+            buildIndex();
+
+        // several patients may share the name: take the most urgent one
+        const std::vector<int>* slots = index.find(name);
+        if (slots != nullptr)
+        {
+            for (int slot: *slots)
+            {
+                if (found < 0 || before(heap[slot], heap[found]))
+                    found = slot;
+            }
+        }
+        return found;
+    }
+
+    for (size_t i = 0; i < heap.size(); ++i)
+    {
+        if (nameOf(heap[i]) == name && (found < 0 || before(heap[i], heap[found])))
+            found = i;
+    }
+
+    return found;
+}
+
+// Maps every name to its heap slots, after the index was left out of date
+template <typename Storage, typename Compare, int Arity, typename Index>
+void BasicPatientQueue<Storage, Compare, Arity, Index>::buildIndex()
+{
+    index.clear();
+    for (size_t i = 0; i < heap.size(); ++i)
+        index.added(nameOf(heap[i]), i);
+}
+
+#endif // _basicpatientqueue_h
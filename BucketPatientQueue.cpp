@@ -0,0 +1,526 @@
+/*
+ * BucketPatientQueue.cpp
+ *
+ * This file implements the members of the BucketPatientQueue class.
+ */
+
+#include "BucketPatientQueue.h"
+
+#include <algorithm>
+#include <climits>
+#include <sstream>
+
+using namespace std;
+
+// Constructor. Creates empty queue
+BucketPatientQueue::BucketPatientQueue()
+    : base(0), cursor(0), count(0), timestamp(0)
+{
+}
+
+// Destructor. Do anything
+BucketPatientQueue::~BucketPatientQueue()
+{
+}
+
+// Removes all elements from the patient queue
+void BucketPatientQueue::clear()
+{
+    STATS_TIME(CLEAR);
+    entries.clear();
+    freeIds.clear();
+    buckets.clear();
+    overflow.clear();
+    index.clear();
+    base = cursor = count = timestamp = 0;
+}
+
+// Returns the name of the most urgent patient.
+// Throws string exception if the queue does not contain any patients.
+string BucketPatientQueue::frontName()
+{
+    STATS_TIME(FRONT_NAME);
+    if (isEmpty())
+        throw frontNameExceptStr();
+    return entries[findMostUrgent()].name;
+}
+
+// Returns the integer priority of the most urgent patient
+// Throws string exception if the queue does not contain any patients.
+int BucketPatientQueue::frontPriority()
+{
+    STATS_TIME(FRONT_PRIORITY);
+    if (isEmpty())
+        throw frontPriorityExceptStr();
+    return entries[findMostUrgent()].priority;
+}
+
+// Returns true if your patient queue does not contain any elements
+// and false if it does contain at least one patient.
+bool BucketPatientQueue::isEmpty()
+{
+    return (count == 0);
+}
+
+// Adds the given person into the patient queue with the given priority.
+void BucketPatientQueue::newPatient(string name, int priority)
+{
+    STATS_TIME(NEW_PATIENT);
+    STATS_DEPTH(count);
+    add(move(name), priority);
+}
+
+// Adds all given patients in order.
+void BucketPatientQueue::newPatients(const Vector<PatientRecord>& patients)
+{
+    STATS_TIME(NEW_PATIENTS);
+    STATS_GROWTH(entries, entries.reserve(entries.size() + patients.size()));
+    for (const auto &patient: patients)
+    {
+        STATS_DEPTH(count);
+        add(patient.name, patient.priority);
+    }
+}
+
+// Removes the patient with the most urgent priority from the queue,
+// and you returns their name as a string.
+// Throws string exception if the queue does not contain any patients.
+string BucketPatientQueue::processPatient()
+{
+    STATS_TIME(PROCESS_PATIENT);
+    if (isEmpty())
+        throw processPatientExceptStr();
+
+    int id = takeMostUrgent();
+    indexRemove(entries[id].name, id);
+    string name = move(entries[id].name);
+    freeEntry(id);
+    --count;
+
+    // start over when the queue is empty,
+    // so the buckets can follow a new range of priorities
+    if (count == 0)
+        clear();
+
+    return name;
+}
+
+// Removes up to k most urgent patients and returns their names in order
+Vector<string> BucketPatientQueue::processPatients(int k)
+{
+    STATS_TIME(PROCESS_PATIENTS);
+    Vector<string> processed;
+
+    while (count > 0 && processed.size() < k)
+    {
+        int id = takeMostUrgent();
+        indexRemove(entries[id].name, id);
+        processed.add(string());
+        processed[processed.size() - 1] = move(entries[id].name);
+        freeEntry(id);
+        --count;
+    }
+
+    if (count == 0)
+        clear();
+
+    return processed;
+}
+
+// Returns up to k most urgent patients without changing the queue.
+// The first k entries of the buckets are merged
+// with the first k entries of the overflow heap.
+Vector<PatientRecord> BucketPatientQueue::peekTop(int k)
+{
+    STATS_TIME(PEEK_TOP);
+    Vector<PatientRecord> top;
+    if (k <= 0 || isEmpty())
+        return top;
+
+    // buckets are already in order
+    vector<int> inBuckets;
+    for (int b = cursor; b < static_cast<int>(buckets.size()) && static_cast<int>(inBuckets.size()) < k; ++b)
+    {
+        const Bucket &bucket = buckets[b];
+        for (size_t i = bucket.head; i < bucket.ids.size() && static_cast<int>(inBuckets.size()) < k; ++i)
+        {
+            if (!entries[bucket.ids[i]].removed)
+                inBuckets.push_back(bucket.ids[i]);
+        }
+    }
+
+    // walk the overflow heap from its root, removed entries still lead to their children
+    vector<int> inOverflow;
+    auto later = [this](int s1, int s2) { return compare(overflow[s2], overflow[s1]); };
+    vector<int> frontier;
+    if (!overflow.empty())
+        frontier.push_back(0);
+
+    while (!frontier.empty() && static_cast<int>(inOverflow.size()) < k)
+    {
+        pop_heap(frontier.begin(), frontier.end(), later);
+        int slot = frontier.back();
+        frontier.pop_back();
+
+        if (!entries[overflow[slot]].removed)
+            inOverflow.push_back(overflow[slot]);
+
+        for (int child = slot * 2 + 1; child <= slot * 2 + 2 && child < static_cast<int>(overflow.size()); ++child)
+        {
+            frontier.push_back(child);
+            push_heap(frontier.begin(), frontier.end(), later);
+        }
+    }
+
+    vector<int> ids(inBuckets.size() + inOverflow.size());
+    merge(inBuckets.begin(), inBuckets.end(), inOverflow.begin(), inOverflow.end(), ids.begin(),
+          [this](int id1, int id2) { return compare(id1, id2); });
+
+    for (int i = 0; i < k && i < static_cast<int>(ids.size()); ++i)
+    {
+        PatientRecord patient;
+        patient.name = entries[ids[i]].name;
+        patient.priority = entries[ids[i]].priority;
+        top.add(patient);
+    }
+
+    return top;
+}
+
+// Modifies the priority of a given existing patient in the queue.
+// Throws string exception if the given patient is present in the queue and already
+// has a more urgent priority than the given new priority.
+// Throws string exception if the given patient is not already in the queue
+void BucketPatientQueue::upgradePatient(string name, int newPriority)
+{
+    STATS_TIME(UPGRADE_PATIENT);
+    auto iter = index.find(name);
+    STATS_SEARCH(iter == index.end() ? 0 : iter->second.size());
+
+    if (iter == index.end())
+        throw upgradeNoPatientExceptStr(name, newPriority);
+
+    // several patients may share the name: take the most urgent one
+    int found = iter->second[0];
+    for (int id: iter->second)
+    {
+        if (compare(id, found))
+            found = id;
+    }
+
+    if (entries[found].priority <= newPriority)
+        throw upgradeWrongPriorityExceptStr(name, newPriority, entries[found].priority);
+
+    // old entry stays in its bucket until it is reached,
+    // the patient is queued again as a new arrival
+    entries[found].removed = true;
+    indexRemove(name, found);
+    --count;
+
+    add(move(name), newPriority);
+}
+
+// Removes the most urgent patient with the given name from the queue.
+// Throws string exception if the given patient is not in the queue
+void BucketPatientQueue::removePatient(string name)
+{
+    STATS_TIME(REMOVE_PATIENT);
+    auto iter = index.find(name);
+    STATS_SEARCH(iter == index.end() ? 0 : iter->second.size());
+
+    if (iter == index.end())
+        throw removeNoPatientExceptStr(name);
+
+    int found = iter->second[0];
+    for (int id: iter->second)
+    {
+        if (compare(id, found))
+            found = id;
+    }
+
+    // the entry stays in its bucket until it is reached, like after an upgrade
+    entries[found].removed = true;
+    indexRemove(name, found);
+    --count;
+
+    if (count == 0)
+        clear();
+}
+
+// Returns string representation of the queue
+// in the form of "{priority1:value1, priority2:value2}"
+string BucketPatientQueue::toString()
+{
+    STATS_TIME(TO_STRING);
+    if (isEmpty())
+        return "{}";
+
+    // list patients in the order they will be processed
+    vector<int> ids;
+    for (const auto &names: index)
+        ids.insert(ids.end(), names.second.begin(), names.second.end());
+    sort(ids.begin(), ids.end(), [this](int id1, int id2) { return compare(id1, id2); });
+
+    stringstream str;
+
+    str << "{" << entries[ids[0]].priority << ":" << entries[ids[0]].name;
+
+    for (size_t i = 1; i < ids.size(); ++i)
+    {
+        str << ", " << entries[ids[i]].priority << ":" << entries[ids[i]].name;
+    }
+    str << "}";
+
+    return str.str();
+}
+
+// Creates an entry for the patient and puts it into a bucket,
+// or into the overflow heap if its priority is out of bucket range
+void BucketPatientQueue::add(string name, int priority)
+{
+    int id;
+    if (freeIds.empty())
+    {
+        id = entries.size();
+        STATS_GROWTH(entries, entries.push_back(Entry()));
+    }
+    else
+    {
+        id = freeIds.back();
+        freeIds.pop_back();
+    }
+
+    Entry &entry = entries[id];
+    entry.name = move(name);
+    entry.priority = priority;
+    entry.timestamp = ++timestamp;
+    entry.removed = false;
+
+    index[entry.name].push_back(id);
+    ++count;
+
+    if (fitBuckets(priority))
+    {
+        int bucket = priority - base;
+        STATS_GROWTH(buckets[bucket].ids, buckets[bucket].ids.push_back(id));
+        if (bucket < cursor)
+            cursor = bucket;
+    }
+    else
+    {
+        STATS_GROWTH(overflow, overflow.push_back(id));
+        overflowUp(overflow.size() - 1);
+    }
+}
+
+// Extends the buckets to cover given priority.
+// Returns false if they would cover more than MAX_BUCKETS priorities.
+bool BucketPatientQueue::fitBuckets(int priority)
+{
+    if (buckets.empty())
+    {
+        base = priority;
+        cursor = 0;
+        STATS_GROWTH(buckets, buckets.resize(1));
+        return true;
+    }
+
+    long long top = static_cast<long long>(base) + buckets.size(); // one past the last bucket
+
+    if (priority < base)
+    {
+        if (top - priority > MAX_BUCKETS)
+            return false;
+
+        // add buckets at the front, at least as many as there are already,
+        // so priorities coming down one by one move the buckets only
+        // a logarithmic number of times
+        long long newBase = min(static_cast<long long>(priority), base - static_cast<long long>(buckets.size()));
+        newBase = max(newBase, max(top - MAX_BUCKETS, static_cast<long long>(INT_MIN)));
+        int shift = base - newBase;
+        STATS_GROWTH(buckets, buckets.insert(buckets.begin(), shift, Bucket()));
+        STATS_MOVES(buckets.size() - shift);
+        base = newBase;
+        cursor += shift;
+    }
+    else if (priority >= top)
+    {
+        if (static_cast<long long>(priority) - base + 1 > MAX_BUCKETS)
+            return false;
+
+        STATS_GROWTH(buckets, buckets.resize(priority - base + 1));
+    }
+
+    return true;
+}
+
+// Returns entry id of the most urgent patient
+int BucketPatientQueue::findMostUrgent()
+{
+    int inBuckets = frontOfBuckets();
+    int inOverflow = frontOfOverflow();
+
+    if (inBuckets < 0)
+        return inOverflow;
+    if (inOverflow < 0)
+        return inBuckets;
+
+    return compare(inBuckets, inOverflow) ? inBuckets : inOverflow;
+}
+
+// Takes the most urgent patient out of its bucket or the overflow heap
+// Returns its entry id
+int BucketPatientQueue::takeMostUrgent()
+{
+    int id = findMostUrgent();
+
+    if (!overflow.empty() && overflow[0] == id)
+    {
+        overflow[0] = overflow.back();
+        overflow.pop_back();
+        STATS_MOVE();
+        if (!overflow.empty())
+            overflowDown(0);
+    }
+    else
+    {
+        takeFront(buckets[cursor]);
+    }
+
+    return id;
+}
+
+// Moves cursor to the first bucket with a queued patient
+// Returns entry id of that patient or -1 if buckets are empty
+int BucketPatientQueue::frontOfBuckets()
+{
+    for (; cursor < static_cast<int>(buckets.size()); ++cursor)
+    {
+        Bucket &bucket = buckets[cursor];
+
+        // drop entries left behind by upgrades
+        while (bucket.head < bucket.ids.size() && entries[bucket.ids[bucket.head]].removed)
+        {
+            freeEntry(bucket.ids[bucket.head]);
+            takeFront(bucket);
+        }
+
+        if (bucket.head < bucket.ids.size())
+            return bucket.ids[bucket.head];
+    }
+
+    return -1;
+}
+
+// Takes the first id out of the bucket. Ids taken out are erased once they
+// are more than half of the bucket, so a bucket that never drains under
+// steady arrivals does not grow, and every id is moved at most once per take
+void BucketPatientQueue::takeFront(Bucket &bucket)
+{
+    ++bucket.head;
+    if (bucket.head > bucket.ids.size() / 2)
+    {
+        STATS_MOVES(bucket.ids.size() - bucket.head);
+        bucket.ids.erase(bucket.ids.begin(), bucket.ids.begin() + bucket.head);
+        bucket.head = 0;
+    }
+}
+
+// Returns entry id of the most urgent patient in the overflow heap
+// or -1 if it is empty
+int BucketPatientQueue::frontOfOverflow()
+{
+    // drop entries left behind by upgrades
+    while (!overflow.empty() && entries[overflow[0]].removed)
+    {
+        freeEntry(overflow[0]);
+        overflow[0] = overflow.back();
+        overflow.pop_back();
+        STATS_MOVE();
+        if (!overflow.empty())
+            overflowDown(0);
+    }
+
+    return overflow.empty() ? -1 : overflow[0];
+}
+
+// Makes entry id available for new patients
+void BucketPatientQueue::freeEntry(int id)
+{
+    entries[id].name.clear();
+    freeIds.push_back(id);
+}
+
+// compare two entries: by priority, then by order of arrival
+bool BucketPatientQueue::compare(int id1, int id2)
+{
+    STATS_COMPARE();
+
+    if (entries[id1].priority != entries[id2].priority)
+        return entries[id1].priority < entries[id2].priority;
+
+    return entries[id1].timestamp < entries[id2].timestamp;
+}
+
+// move overflow heap node up on the tree
+void BucketPatientQueue::overflowUp(int slot)
+{
+    while (slot > 0)
+    {
+        int parent = (slot - 1) / 2;
+        if (!compare(overflow[slot], overflow[parent]))
+            break;
+
+        swap(overflow[slot], overflow[parent]);
+        STATS_MOVE();
+        slot = parent;
+    }
+}
+
+// move overflow heap node down on the tree
+void BucketPatientQueue::overflowDown(int slot)
+{
+    int size = overflow.size();
+
+    while (true)
+    {
+        int urgent = slot;
+        int left = slot * 2 + 1;
+        int right = slot * 2 + 2;
+
+        if (left < size && compare(overflow[left], overflow[urgent]))
+            urgent = left;
+
+        if (right < size && compare(overflow[right], overflow[urgent]))
+            urgent = right;
+
+        if (urgent == slot)
+            break;
+
+        swap(overflow[slot], overflow[urgent]);
+        STATS_MOVE();
+        slot = urgent;
+    }
+}
+
+// Removes entry id of the patient with given name from the index
+void BucketPatientQueue::indexRemove(const string &name, int id)
+{
+    auto iter = index.find(name);
+    if (iter == index.end())
+        return;
+
+    vector<int> &ids = iter->second;
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        if (ids[i] == id)
+        {
+            ids[i] = ids.back();
+            ids.pop_back();
+            break;
+        }
+    }
+
+    if (ids.empty())
+        index.erase(iter);
+}
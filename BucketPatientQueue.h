@@ -0,0 +1,80 @@
+/*
+ * BucketPatientQueue.h
+ *
+ * This file declares the BucketPatientQueue class, a patient queue for
+ * small integer priorities. Patients are kept in FIFO buckets indexed by
+ * priority, and a cursor points to the most urgent bucket that may be
+ * non-empty. Priorities too far from the others to fit into the buckets
+ * go to an overflow heap.
+ */
+
+#ifndef _bucketpatientqueue_h
+#define _bucketpatientqueue_h
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "patientqueue.h"
+
+class BucketPatientQueue : public PatientQueue {
+public:
+    BucketPatientQueue();
+    ~BucketPatientQueue();
+    std::string frontName();
+    void clear();
+    int frontPriority();
+    bool isEmpty();
+    void newPatient(std::string name, int priority);
+    void newPatients(const Vector<PatientRecord>& patients);
+    std::string processPatient();
+    Vector<std::string> processPatients(int k);
+    Vector<PatientRecord> peekTop(int k);
+    void upgradePatient(std::string name, int newPriority);
+    void removePatient(std::string name);
+    std::string toString();
+
+private:
+    // the most priorities covered by buckets at once
+    static const int MAX_BUCKETS = 1 << 16;
+
+    struct Entry
+    {
+        std::string name;
+        int priority;
+        int timestamp; // order of arrival, used to break ties
+        bool removed;  // upgraded entries are skipped when reached
+    };
+
+    struct Bucket
+    {
+        std::vector<int> ids; // entry ids in order of arrival
+        size_t head;          // first id not yet taken out, at most half of ids
+    };
+
+    std::vector<Entry> entries;
+    std::vector<int> freeIds;
+    std::vector<Bucket> buckets; // buckets[i] holds priority base + i
+    int base;
+    int cursor;                  // no patients in buckets before this one
+    std::vector<int> overflow;   // heap of entry ids out of bucket range
+    // patient name -> ids of queued entries with that name
+    std::unordered_map<std::string, std::vector<int>> index;
+    int count;
+    int timestamp;
+
+    void add(std::string name, int priority);
+    bool fitBuckets(int priority);
+    int findMostUrgent();
+    int takeMostUrgent();
+    int frontOfBuckets();
+    void takeFront(Bucket &bucket);
+    int frontOfOverflow();
+    void freeEntry(int id);
+    bool compare(int id1, int id2);
+    void overflowUp(int slot);
+    void overflowDown(int slot);
+    void indexRemove(const std::string &name, int id);
+};
+
+#endif // _bucketpatientqueue_h
@@ -0,0 +1,376 @@
+/*
+ * ConcurrentPatientQueue.cpp
+ *
+ * This file implements the members of the ConcurrentPatientQueue class.
+ */
+
+#include "ConcurrentPatientQueue.h"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Constructor. Creates empty queue with given number of shards
+ConcurrentPatientQueue::ConcurrentPatientQueue(Ordering ordering, int shards)
+    : ordering(ordering), shardCount(shards), count(0)
+{
+    if (shardCount <= 0)
+        shardCount = 2 * max(1u, thread::hardware_concurrency());
+
+    this->shards.reset(new Shard[shardCount]);
+}
+
+// Destructor. Shards free their heaps themselves
+ConcurrentPatientQueue::~ConcurrentPatientQueue()
+{
+}
+
+// Removes all elements from the patient queue
+void ConcurrentPatientQueue::clear()
+{
+    // hold all locks, so no patient is added in the middle
+    vector<unique_lock<mutex>> locks;
+    for (int i = 0; i < shardCount; ++i)
+        locks.emplace_back(shards[i].lock);
+
+    for (int i = 0; i < shardCount; ++i)
+    {
+        shards[i].queue.clear();
+        shards[i].top = EMPTY;
+    }
+    count = 0;
+}
+
+// Returns the name of the most urgent patient.
+// Throws string exception if the queue does not contain any patients.
+string ConcurrentPatientQueue::frontName()
+{
+    vector<unique_lock<mutex>> locks;
+    for (int i = 0; i < shardCount; ++i)
+        locks.emplace_back(shards[i].lock);
+
+    int found = findMostUrgent();
+    if (found < 0)
+        throw frontNameExceptStr();
+    return shards[found].queue.frontName();
+}
+
+// Returns the integer priority of the most urgent patient
+// Throws string exception if the queue does not contain any patients.
+int ConcurrentPatientQueue::frontPriority()
+{
+    vector<unique_lock<mutex>> locks;
+    for (int i = 0; i < shardCount; ++i)
+        locks.emplace_back(shards[i].lock);
+
+    int found = findMostUrgent();
+    if (found < 0)
+        throw frontPriorityExceptStr();
+    return shards[found].queue.frontPriority();
+}
+
+// Returns true if your patient queue does not contain any elements
+// and false if it does contain at least one patient.
+// Other threads may change that right after the call.
+bool ConcurrentPatientQueue::isEmpty()
+{
+    return (count == 0);
+}
+
+// Adds the given person into the patient queue with the given priority.
+void ConcurrentPatientQueue::newPatient(string name, int priority)
+{
+    Shard &shard = shards[shardOf(name)];
+
+    lock_guard<mutex> guard(shard.lock);
+    shard.queue.newPatient(move(name), priority);
+    updateTop(shard);
+    ++count;
+}
+
+// Adds all given patients.
+// Patients are grouped by shard, so every shard is locked only once.
+void ConcurrentPatientQueue::newPatients(const Vector<PatientRecord>& patients)
+{
+    vector<Vector<PatientRecord>> batches(shardCount);
+    for (const auto &patient: patients)
+        batches[shardOf(patient.name)].add(patient);
+
+    for (int i = 0; i < shardCount; ++i)
+    {
+        if (batches[i].isEmpty())
+            continue;
+
+        lock_guard<mutex> guard(shards[i].lock);
+        shards[i].queue.newPatients(batches[i]);
+        updateTop(shards[i]);
+        count += batches[i].size();
+    }
+}
+
+// Removes the patient with the most urgent priority from the queue,
+// and you returns their name as a string.
+// Throws string exception if the queue does not contain any patients.
+string ConcurrentPatientQueue::processPatient()
+{
+    if (ordering == RELAXED)
+        return processRelaxed();
+
+    vector<unique_lock<mutex>> locks;
+    for (int i = 0; i < shardCount; ++i)
+        locks.emplace_back(shards[i].lock);
+
+    int found = findMostUrgent();
+    if (found < 0)
+        throw processPatientExceptStr();
+
+    string name = shards[found].queue.processPatient();
+    updateTop(shards[found]);
+    --count;
+
+    return name;
+}
+
+// Removes up to k most urgent patients and returns their names.
+// In STRICT mode all shards are locked once for the whole batch.
+Vector<string> ConcurrentPatientQueue::processPatients(int k)
+{
+    Vector<string> processed;
+
+    if (ordering == RELAXED)
+    {
+        while (processed.size() < k && count > 0)
+        {
+            try
+            {
+                processed.add(string());
+                processed[processed.size() - 1] = processRelaxed();
+            }
+            catch (const string &)
+            {
+                // other threads took the last patients
+                processed.remove(processed.size() - 1);
+                break;
+            }
+        }
+        return processed;
+    }
+
+    vector<unique_lock<mutex>> locks;
+    for (int i = 0; i < shardCount; ++i)
+        locks.emplace_back(shards[i].lock);
+
+    while (processed.size() < k)
+    {
+        int found = findMostUrgent();
+        if (found < 0)
+            break;
+
+        processed.add(string());
+        processed[processed.size() - 1] = shards[found].queue.processPatient();
+        updateTop(shards[found]);
+        --count;
+    }
+
+    return processed;
+}
+
+// Returns up to k most urgent patients without changing the queue.
+// Always strict: the top k of every shard are merged.
+Vector<PatientRecord> ConcurrentPatientQueue::peekTop(int k)
+{
+    Vector<PatientRecord> top;
+    if (k <= 0)
+        return top;
+
+    vector<unique_lock<mutex>> locks;
+    for (int i = 0; i < shardCount; ++i)
+        locks.emplace_back(shards[i].lock);
+
+    vector<PatientRecord> candidates;
+    for (int i = 0; i < shardCount; ++i)
+    {
+        for (const auto &patient: shards[i].queue.peekTop(k))
+            candidates.push_back(patient);
+    }
+
+    // order like HeapPatientQueue does: by priority, then by name
+    auto urgent = [](const PatientRecord &p1, const PatientRecord &p2) {
+        if (p1.priority != p2.priority)
+            return p1.priority < p2.priority;
+        return p1.name < p2.name;
+    };
+
+    int size = min(k, static_cast<int>(candidates.size()));
+    partial_sort(candidates.begin(), candidates.begin() + size, candidates.end(), urgent);
+
+    for (int i = 0; i < size; ++i)
+        top.add(candidates[i]);
+
+    return top;
+}
+
+// Modifies the priority of a given existing patient in the queue.
+// Throws string exception if the given patient is present in the queue and already
+// has a more urgent priority than the given new priority.
+// Throws string exception if the given patient is not already in the queue
+void ConcurrentPatientQueue::upgradePatient(string name, int newPriority)
+{
+    // all patients with this name are in the same shard
+    Shard &shard = shards[shardOf(name)];
+
+    lock_guard<mutex> guard(shard.lock);
+    shard.queue.upgradePatient(name, newPriority);
+    updateTop(shard);
+}
+
+// Removes the most urgent patient with the given name from the queue.
+// Throws string exception if the given patient is not in the queue
+void ConcurrentPatientQueue::removePatient(string name)
+{
+    Shard &shard = shards[shardOf(name)];
+
+    lock_guard<mutex> guard(shard.lock);
+    shard.queue.removePatient(name);
+    updateTop(shard);
+    --count;
+}
+
+// Returns string representation of the queue
+// in the form of "{priority1:value1, priority2:value2}"
+string ConcurrentPatientQueue::toString()
+{
+    stringstream str;
+    str << "{";
+
+    bool first = true;
+    for (int i = 0; i < shardCount; ++i)
+    {
+        lock_guard<mutex> guard(shards[i].lock);
+        if (shards[i].queue.isEmpty())
+            continue;
+
+        // strip braces from the shard's own string
+        string shard = shards[i].queue.toString();
+        if (!first)
+            str << ", ";
+        str << shard.substr(1, shard.size() - 2);
+        first = false;
+    }
+    str << "}";
+
+    return str.str();
+}
+
+// Adds up the statistics of the shards, each one read under its lock
+QueueStats ConcurrentPatientQueue::stats()
+{
+    QueueStats total;
+    for (int i = 0; i < shardCount; ++i)
+    {
+        lock_guard<mutex> guard(shards[i].lock);
+        total += shards[i].queue.stats();
+    }
+    return total;
+}
+
+// Sets the statistics of all shards to zero
+void ConcurrentPatientQueue::resetStats()
+{
+    for (int i = 0; i < shardCount; ++i)
+    {
+        lock_guard<mutex> guard(shards[i].lock);
+        shards[i].queue.resetStats();
+    }
+}
+
+// Returns shard for patients with given name
+int ConcurrentPatientQueue::shardOf(const string &name)
+{
+    return hash<string>()(name) % shardCount;
+}
+
+// Returns random shard, every thread has its own generator
+int ConcurrentPatientQueue::randomShard()
+{
+    static thread_local mt19937 generator(hash<thread::id>()(this_thread::get_id()));
+    return generator() % shardCount;
+}
+
+// Publishes front priority of the shard for processRelaxed()
+// Shard must be locked
+void ConcurrentPatientQueue::updateTop(Shard &shard)
+{
+    shard.top = shard.queue.isEmpty() ? EMPTY : shard.queue.frontPriority();
+}
+
+// Returns shard with the most urgent front patient or -1 if all are empty
+// All shards must be locked
+int ConcurrentPatientQueue::findMostUrgent()
+{
+    int found = -1;
+
+    for (int i = 0; i < shardCount; ++i)
+    {
+        HeapPatientQueue &queue = shards[i].queue;
+        if (queue.isEmpty())
+            continue;
+
+        if (found < 0)
+        {
+            found = i;
+            continue;
+        }
+
+        // compare fronts like HeapPatientQueue does: by priority, then by name
+        HeapPatientQueue &best = shards[found].queue;
+        if (queue.frontPriority() < best.frontPriority()
+                || (queue.frontPriority() == best.frontPriority() && queue.frontName() < best.frontName()))
+            found = i;
+    }
+
+    return found;
+}
+
+// Processes the more urgent front of two random shards.
+// Busy shards are skipped; if no sample succeeds, shards are tried in order.
+string ConcurrentPatientQueue::processRelaxed()
+{
+    for (int attempt = 0; attempt < shardCount; ++attempt)
+    {
+        int first = randomShard();
+        int second = randomShard();
+        int chosen = (shards[second].top < shards[first].top) ? second : first;
+
+        if (shards[chosen].top == EMPTY)
+            continue;
+
+        unique_lock<mutex> guard(shards[chosen].lock, try_to_lock);
+        if (!guard.owns_lock() || shards[chosen].queue.isEmpty())
+            continue;
+
+        string name = shards[chosen].queue.processPatient();
+        updateTop(shards[chosen]);
+        --count;
+        return name;
+    }
+
+    for (int i = 0; i < shardCount; ++i)
+    {
+        lock_guard<mutex> guard(shards[i].lock);
+        if (shards[i].queue.isEmpty())
+            continue;
+
+        string name = shards[i].queue.processPatient();
+        updateTop(shards[i]);
+        --count;
+        return name;
+    }
+
+    throw processPatientExceptStr();
+}
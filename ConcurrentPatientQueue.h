@@ -0,0 +1,76 @@
+/*
+ * ConcurrentPatientQueue.h
+ *
+ * This file declares the ConcurrentPatientQueue class, a patient queue that
+ * can be shared by several check-in desks and treatment rooms running in
+ * different threads. Patients are spread over shards, each one a heap with
+ * its own lock, by the hash of their name, so all patients with the same
+ * name are in the same shard.
+ *
+ * In STRICT mode processPatient() always returns the most urgent patient.
+ * In RELAXED mode it looks at two random shards only and returns the more
+ * urgent of their fronts, which scales with the number of threads but may
+ * return a patient that is slightly less urgent than the true front.
+ */
+
+#ifndef _concurrentpatientqueue_h
+#define _concurrentpatientqueue_h
+
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "HeapPatientQueue.h"
+#include "patientqueue.h"
+
+class ConcurrentPatientQueue : public PatientQueue {
+public:
+    enum Ordering { STRICT, RELAXED };
+
+    // shards = 0 means two shards per hardware thread
+    explicit ConcurrentPatientQueue(Ordering ordering = STRICT, int shards = 0);
+    ~ConcurrentPatientQueue();
+    std::string frontName();
+    void clear();
+    int frontPriority();
+    bool isEmpty();
+    void newPatient(std::string name, int priority);
+    void newPatients(const Vector<PatientRecord>& patients);
+    std::string processPatient();
+    Vector<std::string> processPatients(int k);
+    Vector<PatientRecord> peekTop(int k);
+    void upgradePatient(std::string name, int newPriority);
+    void removePatient(std::string name);
+    std::string toString();
+
+    // Sum of the statistics of the shards, which count their own work;
+    // the depth histogram shows the depth of single shards
+    QueueStats stats();
+    void resetStats();
+
+private:
+    static const long long EMPTY = 1LL << 40; // top of an empty shard
+
+    struct Shard
+    {
+        std::mutex lock;
+        HeapPatientQueue queue;
+        std::atomic<long long> top; // front priority, read without the lock
+
+        Shard() : queue(true), top(EMPTY) {}
+    };
+
+    Ordering ordering;
+    int shardCount;
+    std::unique_ptr<Shard[]> shards;
+    std::atomic<int> count;
+
+    int shardOf(const std::string &name);
+    int randomShard();
+    void updateTop(Shard &shard);
+    int findMostUrgent();
+    std::string processRelaxed();
+};
+
+#endif // _concurrentpatientqueue_h
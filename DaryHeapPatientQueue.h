@@ -0,0 +1,22 @@
+/*
+ * DaryHeapPatientQueue.h
+ *
+ * This file declares the DaryHeapPatientQueue template, a patient queue
+ * implemented as a d-ary min-heap. The heap itself holds only small
+ * (rank, priority, name id) keys in a contiguous array, while the names
+ * live in a separate table and never move, so sifting the heap does not
+ * touch any strings unless two priorities and the first bytes of the
+ * names are equal. It is the BasicPatientQueue template over PatientKey,
+ * ordered by priority, then by name.
+ */
+
+#ifndef _daryheappatientqueue_h
+#define _daryheappatientqueue_h
+
+#include <vector>
+#include "BasicPatientQueue.h"
+
+template <int Arity = 4>
+using DaryHeapPatientQueue = BasicPatientQueue<std::vector<PatientKey>, ByName, Arity>;
+
+#endif // _daryheappatientqueue_h
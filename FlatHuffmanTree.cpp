@@ -0,0 +1,73 @@
+/*
+ * FlatHuffmanTree.cpp
+ *
+ * This file implements the members of the FlatHuffmanTree class.
+ */
+
+#include "FlatHuffmanTree.h"
+
+#include <algorithm>
+
+using namespace std;
+
+// Constructor. The leaves come in the order of the table
+FlatHuffmanTree::FlatHuffmanTree(const Map<int, int>& freqTable)
+{
+    vector<HuffmanNode> leaves;
+    for (int symbol: freqTable)
+        leaves.push_back(HuffmanNode(symbol, freqTable.get(symbol)));
+    build(leaves);
+}
+
+// Constructor. PSEUDO_EOF occurs once, as in frequencyTable()
+FlatHuffmanTree::FlatHuffmanTree(const uint64_t counts[256])
+{
+    vector<HuffmanNode> leaves;
+    for (int ch = 0; ch < 256; ++ch)
+    {
+        if (counts[ch] != 0)
+            leaves.push_back(HuffmanNode(ch, counts[ch]));
+    }
+    leaves.push_back(HuffmanNode(PSEUDO_EOF, 1));
+    build(leaves);
+}
+
+HuffmanNode* FlatHuffmanTree::root()
+{
+    return nodes.empty() ? nullptr : &nodes.back();
+}
+
+int FlatHuffmanTree::nodeCount() const
+{
+    return nodes.size();
+}
+
+// Sorts the leaves by count, keeping the order of equal counts, then
+// merges the two lightest nodes of the queue fronts until one is left.
+// The array has room for all nodes from the start, so the pointers
+// between them stay valid.
+void FlatHuffmanTree::build(vector<HuffmanNode>& leaves)
+{
+    stable_sort(leaves.begin(), leaves.end(), [](const HuffmanNode& a, const HuffmanNode& b) {
+        return a.count < b.count;
+    });
+
+    size_t count = leaves.size();
+    nodes.reserve(count == 0 ? 0 : 2 * count - 1);
+    nodes.assign(leaves.begin(), leaves.end());
+
+    size_t leaf = 0;        // front of the leaf queue
+    size_t merged = count;  // front of the merged queue
+    auto lightest = [&]() -> HuffmanNode* {
+        if (leaf < count && (merged == nodes.size() || nodes[leaf].count <= nodes[merged].count))
+            return &nodes[leaf++];
+        return &nodes[merged++];
+    };
+
+    for (size_t i = 1; i < count; ++i)
+    {
+        HuffmanNode* zero = lightest();
+        HuffmanNode* one = lightest();
+        nodes.push_back(HuffmanNode(NOT_A_CHAR, zero->count + one->count, zero, one));
+    }
+}
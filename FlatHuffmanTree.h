@@ -0,0 +1,55 @@
+/*
+ * FlatHuffmanTree.h
+ *
+ * This file declares the FlatHuffmanTree class, an encoding tree whose
+ * nodes all live in one array owned by the object. It is built with the
+ * two-queue method: the leaves sorted by count form the first queue, and
+ * the merged nodes, which are made in order of count, form the second, so
+ * the two lightest nodes are always at the fronts of the queues. Building
+ * takes one sort of at most 257 counts and no allocation per node, and the
+ * whole tree is freed at once with the object.
+ *
+ * Ties go to the leaves, then to the older merged node, as in the priority
+ * queue of buildEncodingTree(), so both build the same tree.
+ */
+
+#ifndef _flathuffmantree_h
+#define _flathuffmantree_h
+
+#include <cstdint>
+#include <vector>
+#include "HuffmanNode.h"
+#include "map.h"
+
+class FlatHuffmanTree {
+public:
+    /*
+     * Builds the tree of the frequency table, as buildEncodingTree() does.
+     */
+    explicit FlatHuffmanTree(const Map<int, int>& freqTable);
+
+    /*
+     * Builds the tree of the characters with a count and PSEUDO_EOF,
+     * the frequency table frequencyTable() makes of the counts.
+     */
+    explicit FlatHuffmanTree(const uint64_t counts[256]);
+
+    /*
+     * Returns the root of the tree, nullptr for an empty frequency table.
+     * The nodes belong to the tree, so never pass it to freeTree().
+     */
+    HuffmanNode* root();
+
+    int nodeCount() const;
+
+private:
+    std::vector<HuffmanNode> nodes;
+
+    void build(std::vector<HuffmanNode>& leaves);
+
+    // nodes point to each other inside the array, so it can not be copied
+    FlatHuffmanTree(const FlatHuffmanTree&);
+    FlatHuffmanTree& operator =(const FlatHuffmanTree&);
+};
+
+#endif // _flathuffmantree_h
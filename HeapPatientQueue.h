@@ -0,0 +1,20 @@
+/*
+ * HeapPatientQueue.h
+ *
+ * This file declares the HeapPatientQueue class, a patient queue
+ * implemented as a binary min-heap of patients ordered by priority,
+ * then by name. It is the BasicPatientQueue template with a name index:
+ * HeapPatientQueue(true) keeps a name-to-slot index, so upgradePatient()
+ * and removePatient() do not have to search the whole heap, while
+ * HeapPatientQueue() searches. Both can be stored in snapshots.
+ */
+
+#ifndef _heappatientqueue_h
+#define _heappatientqueue_h
+
+#include <vector>
+#include "BasicPatientQueue.h"
+
+typedef BasicPatientQueue<std::vector<PatientEntry>, ByName, 2, NameIndex> HeapPatientQueue;
+
+#endif // _heappatientqueue_h
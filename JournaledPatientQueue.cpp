@@ -0,0 +1,530 @@
+/*
+ * JournaledPatientQueue.cpp
+ *
+ * This file implements the members of the JournaledPatientQueue class.
+ *
+ * The snapshot file holds a header (magic, generation, payload size) and
+ * the heap array written by HeapPatientQueue::writeSnapshot(). The journal
+ * file holds a header (magic, generation) and one record per change:
+ * type, priority, name length, name and a checksum, so a record torn
+ * by a crash is recognized and dropped. A journal is replayed only on top
+ * of the snapshot of the same generation. Both files are replaced through
+ * a temporary file and a rename, so a crash leaves the old or the new
+ * version, never a mix of them.
+ */
+
+#include "JournaledPatientQueue.h"
+
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+static const char SNAPSHOT_MAGIC[8] = {'P', 'Q', 'S', 'N', 'A', 'P', '0', '1'};
+static const char JOURNAL_MAGIC[8] = {'P', 'Q', 'J', 'R', 'N', 'L', '0', '1'};
+static const size_t RECORD_HEAD = 1 + sizeof(int32_t) + sizeof(uint32_t);
+
+// Function prototypes
+static uint32_t checksum(const char *data, size_t size);
+static void flushToDisk(FILE *file);
+static bool readWhole(const string &file, string &data);
+
+// Constructor. Opens the queue stored at path or creates an empty one
+// Throws string exception if the files can not be read or written.
+JournaledPatientQueue::JournaledPatientQueue(const string &path, int groupSize, int snapshotEvery)
+    : queue(true), path(path), groupSize(groupSize < 1 ? 1 : groupSize),
+      snapshotEvery(snapshotEvery), journal(nullptr), generation(0),
+      pendingCount(0), sinceSnapshot(0), replayed(0), openMs(0)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    recover();
+    chrono::duration<double, milli> ms = chrono::steady_clock::now() - start;
+    openMs = ms.count();
+}
+
+// Destructor. Writes the last group of changes
+JournaledPatientQueue::~JournaledPatientQueue()
+{
+    try
+    {
+        sync();
+    }
+    catch (const string &)
+    {
+        // nothing can be done about it here
+    }
+
+    if (journal != nullptr)
+        fclose(journal);
+}
+
+// Removes all elements from the patient queue
+void JournaledPatientQueue::clear()
+{
+    STATS_TIME(CLEAR);
+    queue.clear();
+    log(CLEAR, 0, "");
+    commit();
+}
+
+// Returns the name of the most urgent patient.
+// Throws string exception if the queue does not contain any patients.
+string JournaledPatientQueue::frontName()
+{
+    STATS_TIME(FRONT_NAME);
+    return queue.frontName();
+}
+
+// Returns the integer priority of the most urgent patient
+// Throws string exception if the queue does not contain any patients.
+int JournaledPatientQueue::frontPriority()
+{
+    STATS_TIME(FRONT_PRIORITY);
+    return queue.frontPriority();
+}
+
+// Returns true if your patient queue does not contain any elements
+// and false if it does contain at least one patient.
+bool JournaledPatientQueue::isEmpty()
+{
+    return queue.isEmpty();
+}
+
+// Adds the given person into the patient queue with the given priority.
+void JournaledPatientQueue::newPatient(string name, int priority)
+{
+    STATS_TIME(NEW_PATIENT);
+    log(NEW, priority, name);
+    queue.newPatient(move(name), priority);
+    commit();
+}
+
+// Adds all given patients in order.
+void JournaledPatientQueue::newPatients(const Vector<PatientRecord>& patients)
+{
+    STATS_TIME(NEW_PATIENTS);
+    queue.newPatients(patients);
+    for (const auto &patient: patients)
+        log(NEW, patient.priority, patient.name);
+    commit();
+}
+
+// Removes the patient with the most urgent priority from the queue,
+// and you returns their name as a string.
+// Throws string exception if the queue does not contain any patients.
+string JournaledPatientQueue::processPatient()
+{
+    STATS_TIME(PROCESS_PATIENT);
+    string name = queue.processPatient();
+    log(PROCESS, 1, "");
+    commit();
+    return name;
+}
+
+// Removes up to k most urgent patients and returns their names in order
+Vector<string> JournaledPatientQueue::processPatients(int k)
+{
+    STATS_TIME(PROCESS_PATIENTS);
+    Vector<string> processed = queue.processPatients(k);
+    if (!processed.isEmpty())
+    {
+        log(PROCESS, processed.size(), "");
+        commit();
+    }
+    return processed;
+}
+
+// Returns up to k most urgent patients without changing the queue
+Vector<PatientRecord> JournaledPatientQueue::peekTop(int k)
+{
+    STATS_TIME(PEEK_TOP);
+    return queue.peekTop(k);
+}
+
+// Modifies the priority of a given existing patient in the queue.
+// Throws string exception if the given patient is present in the queue and already
+// has a more urgent priority than the given new priority.
+// Throws string exception if the given patient is not already in the queue
+void JournaledPatientQueue::upgradePatient(string name, int newPriority)
+{
+    STATS_TIME(UPGRADE_PATIENT);
+    queue.upgradePatient(name, newPriority);
+    log(UPGRADE, newPriority, name);
+    commit();
+}
+
+// Removes the most urgent patient with the given name from the queue.
+// Throws string exception if the given patient is not in the queue
+void JournaledPatientQueue::removePatient(string name)
+{
+    STATS_TIME(REMOVE_PATIENT);
+    queue.removePatient(name);
+    log(REMOVE, 0, name);
+    commit();
+}
+
+// Returns string representation of the queue
+// in the form of "{priority1:value1, priority2:value2}"
+string JournaledPatientQueue::toString()
+{
+    STATS_TIME(TO_STRING);
+    return queue.toString();
+}
+
+// Returns statistics of the heap with the times measured by this queue
+QueueStats JournaledPatientQueue::stats()
+{
+    QueueStats merged = queue.stats();
+
+#if PATIENTQUEUE_STATS
+    for (int i = 0; i < QueueStats::METHODS; ++i)
+    {
+        merged.calls[i] = counters.calls[i];
+        merged.nanoseconds[i] = counters.nanoseconds[i];
+    }
+#endif
+
+    return merged;
+}
+
+// Sets the statistics of this queue and of the heap to zero
+void JournaledPatientQueue::resetStats()
+{
+    PatientQueue::resetStats();
+    queue.resetStats();
+}
+
+// Writes the pending group of changes to disk and waits for it
+// Throws string exception if the journal can not be written.
+void JournaledPatientQueue::sync()
+{
+    if (pending.empty())
+        return;
+
+    if (fwrite(pending.data(), 1, pending.size(), journal) != pending.size())
+        throw string("JournaledPatientQueue: can not write " + path + ".journal.");
+    flushToDisk(journal);
+
+    pending.clear();
+    pendingCount = 0;
+}
+
+// Writes a snapshot of the queue and starts a new, empty journal
+// Throws string exception if the files can not be written.
+void JournaledPatientQueue::snapshot()
+{
+    sync();
+
+    uint64_t next = generation + 1;
+
+    string data(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    data.append(reinterpret_cast<const char *>(&next), sizeof(next));
+    uint64_t size = 0; // filled in below
+    data.append(reinterpret_cast<const char *>(&size), sizeof(size));
+
+    size_t header = data.size();
+    queue.writeSnapshot(data);
+    size = data.size() - header;
+    memcpy(&data[header - sizeof(size)], &size, sizeof(size));
+
+    // the old journal is still valid for the old snapshot until the rename
+    writeFile(path + ".snapshot", data);
+    generation = next;
+    openJournal(true);
+    sinceSnapshot = 0;
+}
+
+// Returns number of changes replayed from the journal when the queue was opened
+int JournaledPatientQueue::recoveredFromJournal() const
+{
+    return replayed;
+}
+
+// Returns time spent opening the queue, in milliseconds
+double JournaledPatientQueue::recoveryMs() const
+{
+    return openMs;
+}
+
+// Loads the snapshot, replays the journal after it and opens the journal
+void JournaledPatientQueue::recover()
+{
+    if (!loadSnapshot())
+        generation = 0;
+    replayJournal();
+}
+
+// Maps the snapshot into memory and loads the heap array from it
+// Returns false if there is no snapshot.
+// Throws string exception if the snapshot is damaged.
+bool JournaledPatientQueue::loadSnapshot()
+{
+    string file = path + ".snapshot";
+    const size_t HEADER = sizeof(SNAPSHOT_MAGIC) + 2 * sizeof(uint64_t);
+
+#ifdef _WIN32
+    string whole;
+    if (!readWhole(file, whole))
+        return false;
+    const char *data = whole.data();
+    size_t size = whole.size();
+#else
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(HEADER))
+    {
+        close(fd);
+        throw string("JournaledPatientQueue: " + file + " is damaged.");
+    }
+
+    size_t size = info.st_size;
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        throw string("JournaledPatientQueue: can not map " + file + ".");
+    const char *data = static_cast<const char *>(mapped);
+#endif
+
+    uint64_t payload = 0;
+    bool ok = size >= HEADER && memcmp(data, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0;
+    if (ok)
+    {
+        memcpy(&generation, data + sizeof(SNAPSHOT_MAGIC), sizeof(generation));
+        memcpy(&payload, data + sizeof(SNAPSHOT_MAGIC) + sizeof(generation), sizeof(payload));
+        ok = payload == size - HEADER;
+    }
+
+    try
+    {
+        if (ok)
+            queue.readSnapshot(data + HEADER, payload);
+    }
+    catch (const string &)
+    {
+        ok = false;
+    }
+
+#ifndef _WIN32
+    munmap(mapped, size);
+#endif
+
+    if (!ok)
+        throw string("JournaledPatientQueue: " + file + " is damaged.");
+    return true;
+}
+
+// Replays the records of the journal that continue the loaded snapshot,
+// then opens the journal for new records. A journal of an older generation
+// is already part of the snapshot and is started over.
+void JournaledPatientQueue::replayJournal()
+{
+    string data;
+    const size_t HEADER = sizeof(JOURNAL_MAGIC) + sizeof(uint64_t);
+
+    uint64_t written = 0;
+    if (!readWhole(path + ".journal", data) || data.size() < HEADER
+            || memcmp(data.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0)
+    {
+        openJournal(true);
+        return;
+    }
+    memcpy(&written, data.data() + sizeof(JOURNAL_MAGIC), sizeof(written));
+    if (written != generation)
+    {
+        openJournal(true);
+        return;
+    }
+
+    size_t offset = HEADER;
+    while (offset + RECORD_HEAD + sizeof(uint32_t) <= data.size())
+    {
+        const char *record = data.data() + offset;
+        int32_t priority;
+        uint32_t length;
+        memcpy(&priority, record + 1, sizeof(priority));
+        memcpy(&length, record + 1 + sizeof(priority), sizeof(length));
+
+        size_t end = offset + RECORD_HEAD + length + sizeof(uint32_t);
+        if (length > data.size() || end > data.size())
+            break;
+
+        uint32_t stored;
+        memcpy(&stored, record + RECORD_HEAD + length, sizeof(stored));
+        if (stored != checksum(record, RECORD_HEAD + length))
+            break;
+
+        apply(record[0], priority, string(record + RECORD_HEAD, length));
+        ++replayed;
+        offset = end;
+    }
+    sinceSnapshot = replayed;
+
+    if (offset == data.size())
+    {
+        openJournal(false);
+    }
+    else
+    {
+        // drop the torn tail, so new records follow the last good one
+        data.resize(offset);
+        writeFile(path + ".journal", data);
+        openJournal(false);
+    }
+}
+
+// Applies one journal record to the queue
+void JournaledPatientQueue::apply(char type, int priority, const string &name)
+{
+    try
+    {
+        switch (type)
+        {
+        case NEW:
+            queue.newPatient(name, priority);
+            break;
+        case PROCESS:
+            queue.processPatients(priority);
+            break;
+        case UPGRADE:
+            queue.upgradePatient(name, priority);
+            break;
+        case REMOVE:
+            queue.removePatient(name);
+            break;
+        case CLEAR:
+            queue.clear();
+            break;
+        }
+    }
+    catch (const string &)
+    {
+        // only changes that succeeded are journaled, so this does not happen
+    }
+}
+
+// Opens the journal for appending records.
+// If create is true a new journal of the current generation replaces the old one.
+void JournaledPatientQueue::openJournal(bool create)
+{
+    if (journal != nullptr)
+        fclose(journal);
+    journal = nullptr;
+
+    string file = path + ".journal";
+    if (create)
+    {
+        string header(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+        header.append(reinterpret_cast<const char *>(&generation), sizeof(generation));
+        writeFile(file, header);
+    }
+
+    journal = fopen(file.c_str(), "ab");
+    if (journal == nullptr)
+        throw string("JournaledPatientQueue: can not open " + file + ".");
+}
+
+// Adds a record to the pending group
+void JournaledPatientQueue::log(char type, int priority, const string &name)
+{
+    size_t start = pending.size();
+
+    int32_t number = priority;
+    uint32_t length = name.size();
+    pending.push_back(type);
+    pending.append(reinterpret_cast<const char *>(&number), sizeof(number));
+    pending.append(reinterpret_cast<const char *>(&length), sizeof(length));
+    pending.append(name);
+
+    uint32_t sum = checksum(pending.data() + start, pending.size() - start);
+    pending.append(reinterpret_cast<const char *>(&sum), sizeof(sum));
+
+    ++pendingCount;
+    ++sinceSnapshot;
+}
+
+// Ends a change: writes the group once it is full
+// and a snapshot once enough changes are journaled
+void JournaledPatientQueue::commit()
+{
+    if (pendingCount >= groupSize)
+        sync();
+
+    if (snapshotEvery > 0 && sinceSnapshot >= snapshotEvery)
+        snapshot();
+}
+
+// Replaces the file with data, through a temporary file and a rename
+// Throws string exception if the file can not be written.
+void JournaledPatientQueue::writeFile(const string &file, const string &data)
+{
+    string temporary = file + ".tmp";
+
+    FILE *out = fopen(temporary.c_str(), "wb");
+    if (out == nullptr)
+        throw string("JournaledPatientQueue: can not write " + temporary + ".");
+
+    bool ok = fwrite(data.data(), 1, data.size(), out) == data.size();
+    if (ok)
+        flushToDisk(out);
+    fclose(out);
+
+#ifdef _WIN32
+    remove(file.c_str()); // rename does not replace files on Windows
+#endif
+    if (!ok || rename(temporary.c_str(), file.c_str()) != 0)
+        throw string("JournaledPatientQueue: can not write " + file + ".");
+}
+
+// FNV-1a hash of the data, used to find torn journal records
+static uint32_t checksum(const char *data, size_t size)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Writes the buffers of the file and waits until the data is on disk
+static void flushToDisk(FILE *file)
+{
+    fflush(file);
+#ifdef _WIN32
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+}
+
+// Reads the whole file into data
+// Returns false if the file does not exist.
+static bool readWhole(const string &file, string &data)
+{
+    FILE *in = fopen(file.c_str(), "rb");
+    if (in == nullptr)
+        return false;
+
+    char buffer[1 << 16];
+    size_t read;
+    data.clear();
+    while ((read = fread(buffer, 1, sizeof(buffer), in)) > 0)
+        data.append(buffer, read);
+
+    fclose(in);
+    return true;
+}
@@ -0,0 +1,99 @@
+/*
+ * JournaledPatientQueue.h
+ *
+ * This file declares the JournaledPatientQueue class, a HeapPatientQueue
+ * that survives a crash of the program. Every change is appended to a
+ * write-ahead journal, and every so often the whole heap array is written
+ * to a binary snapshot and the journal starts over. On construction the
+ * queue maps the snapshot back into memory and replays only the journal
+ * written after it.
+ *
+ * Two files are used for the given path: path.snapshot and path.journal.
+ * Changes are flushed to disk in groups, so a crash loses at most the
+ * changes of the last unfinished group; sync() flushes one right away.
+ * The files use the byte order of the machine that wrote them.
+ */
+
+#ifndef _journaledpatientqueue_h
+#define _journaledpatientqueue_h
+
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include "HeapPatientQueue.h"
+#include "patientqueue.h"
+
+class JournaledPatientQueue : public PatientQueue {
+public:
+    // groupSize changes are written to disk at once, and a snapshot is
+    // written after snapshotEvery changes (0 means only when asked for).
+    // Throws string exception if the files can not be read or written.
+    explicit JournaledPatientQueue(const std::string& path, int groupSize = 64,
+                                   int snapshotEvery = 1000000);
+    ~JournaledPatientQueue();
+    std::string frontName();
+    void clear();
+    int frontPriority();
+    bool isEmpty();
+    void newPatient(std::string name, int priority);
+    void newPatients(const Vector<PatientRecord>& patients);
+    std::string processPatient();
+    Vector<std::string> processPatients(int k);
+    Vector<PatientRecord> peekTop(int k);
+    void upgradePatient(std::string name, int newPriority);
+    void removePatient(std::string name);
+    std::string toString();
+
+    // Statistics of the heap, with the times of this queue's members,
+    // which include writing the journal
+    QueueStats stats();
+    void resetStats();
+
+    // Writes the pending group of changes to disk and waits for it
+    void sync();
+
+    // Writes a snapshot of the queue and starts a new, empty journal
+    void snapshot();
+
+    // Metrics of the last recovery
+    int recoveredFromJournal() const; // changes replayed from the journal
+    double recoveryMs() const;        // time spent opening the queue
+
+private:
+    // record types, the letters of the workload format
+    static const char NEW = 'N';
+    static const char PROCESS = 'P'; // priority field holds the count
+    static const char UPGRADE = 'U';
+    static const char REMOVE = 'R';
+    static const char CLEAR = 'C';
+
+    HeapPatientQueue queue;
+    std::string path;
+    int groupSize;
+    int snapshotEvery;
+
+    FILE *journal;
+    uint64_t generation; // snapshot the journal continues, 0 if none
+    std::string pending; // records of the unfinished group
+    int pendingCount;
+    int sinceSnapshot;   // changes journaled since the last snapshot
+
+    int replayed;
+    double openMs;
+
+    void recover();
+    bool loadSnapshot();
+    void replayJournal();
+    void apply(char type, int priority, const std::string& name);
+    void openJournal(bool create);
+    void log(char type, int priority, const std::string& name);
+    void commit();
+    void writeFile(const std::string& file, const std::string& data);
+
+    // a queue owns its files, so it can not be copied
+    JournaledPatientQueue(const JournaledPatientQueue&);
+    JournaledPatientQueue& operator =(const JournaledPatientQueue&);
+};
+
+#endif // _journaledpatientqueue_h
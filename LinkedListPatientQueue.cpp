@@ -6,38 +6,50 @@
 
 #include "LinkedListPatientQueue.h"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
 
-// Constructor. Creates empty list
+// Constructor. Creates empty list with its own node pool
 LinkedListPatientQueue::LinkedListPatientQueue()
-    : front(nullptr)
+    : front(nullptr), pool(new PatientNodePool()), ownsPool(true)
 {
 }
 
-// Destructor. Frees the memory allocated for nodes
+// Constructor. Creates empty list taking nodes from a shared pool
+LinkedListPatientQueue::LinkedListPatientQueue(PatientNodePool *sharedPool)
+    : front(nullptr), pool(sharedPool), ownsPool(false)
+{
+}
+
+// Destructor. Gives the nodes back to the pool
 LinkedListPatientQueue::~LinkedListPatientQueue()
 {
    clear();
+   if (ownsPool)
+       delete pool;
 }
 
 // Removes all elements from the patient queue
 void LinkedListPatientQueue::clear()
 {
-    // remove nodes from the front until empty list
-    while (front != nullptr)
-    {
-        PatientNode *toDelete = front;
-        front = front->next;
-        delete toDelete;
-    }
+    STATS_TIME(CLEAR);
+    STATS_LEAVE_ALL();
+
+    if (ownsPool)
+        pool->clear(); // nobody else uses the nodes: free all chunks at once
+    else
+        pool->releaseList(front);
+
+    front = nullptr;
 }
 
 // Returns the name of the most urgent patient.
 // Throws string exception if the queue does not contain any patients.
 string LinkedListPatientQueue::frontName()
 {
+    STATS_TIME(FRONT_NAME);
     if (isEmpty())
         throw frontNameExceptStr();
 
@@ -48,6 +60,7 @@ string LinkedListPatientQueue::frontName()
 // Throws string exception if the queue does not contain any patients.
 int LinkedListPatientQueue::frontPriority()
 {
+    STATS_TIME(FRONT_PRIORITY);
     if (isEmpty())
         throw frontPriorityExceptStr();
     return front->priority;
@@ -63,7 +76,10 @@ bool LinkedListPatientQueue::isEmpty()
 // Adds the given person into the patient queue with the given priority.
 void LinkedListPatientQueue::newPatient(string name, int priority)
 {
-    PatientNode *newPatientNode = new PatientNode(name, priority);
+    STATS_TIME(NEW_PATIENT);
+    STATS_ARRIVE();
+
+    PatientNode *newPatientNode = newNode(move(name), priority);
 
     if (isEmpty())
     {
@@ -71,12 +87,14 @@ void LinkedListPatientQueue::newPatient(string name, int priority)
     }
     else if (priority < front->priority) // insert at the front
     {
+        STATS_COMPARE();
         // link nodes
         newPatientNode->next = front;
         front = newPatientNode;
     }
     else // insert in the middle
     {
+        STATS_COMPARE();
         // find a node with a priority greater than or equal to given.
         PatientNode *found = findBeforePriority(priority);
         // link nodes
@@ -85,34 +103,116 @@ void LinkedListPatientQueue::newPatient(string name, int priority)
     }
 }
 
+// Adds all given patients in order.
+// Sorts new patients by priority and merges them into the list in one pass.
+void LinkedListPatientQueue::newPatients(const Vector<PatientRecord>& patients)
+{
+    STATS_TIME(NEW_PATIENTS);
+    // stable sort keeps arrival order of patients with equal priorities
+    Vector<PatientRecord> sorted = patients;
+    stable_sort(sorted.begin(), sorted.end(),
+                [this](const PatientRecord &a, const PatientRecord &b)
+                {
+                    STATS_COMPARE();
+                    return a.priority < b.priority;
+                });
+
+    // as in newPatient() a new node goes after all nodes with
+    // priority less than or equal to its own
+    PatientNode **link = &front;
+    for (const auto &patient: sorted)
+    {
+        STATS_ARRIVE();
+        while (*link != nullptr && (*link)->priority <= patient.priority)
+        {
+            STATS_COMPARE();
+            link = &(*link)->next;
+        }
+
+        *link = newNode(patient.name, patient.priority, *link);
+        link = &(*link)->next;
+    }
+}
+
 // Removes the patient with the most urgent priority from the queue,
 // and you returns their name as a string.
 // Throws string exception if the queue does not contain any patients.
 string LinkedListPatientQueue::processPatient()
 {
+    STATS_TIME(PROCESS_PATIENT);
     if (isEmpty())
         throw processPatientExceptStr();
 
     // remove node from the front of the list
-    string name = front->name;
+    string name = move(front->name);
     PatientNode *toDelete = front;
     front = front->next;
-    delete toDelete;
+    pool->release(toDelete);
+    STATS_LEAVE(1);
 
     return name;
 }
 
+// Removes up to k most urgent patients and returns their names in order.
+// They are the first k nodes, so the prefix is cut off
+// and given back to the pool in one splice.
+Vector<string> LinkedListPatientQueue::processPatients(int k)
+{
+    STATS_TIME(PROCESS_PATIENTS);
+    Vector<string> processed;
+    if (k <= 0 || isEmpty())
+        return processed;
+
+    PatientNode *first = front;
+    PatientNode *last = front;
+    while (true)
+    {
+        processed.add(string());
+        processed[processed.size() - 1] = move(last->name);
+
+        if (processed.size() == k || last->next == nullptr)
+            break;
+        last = last->next;
+    }
+
+    front = last->next;
+    last->next = nullptr;
+    pool->releaseList(first);
+    STATS_LEAVE(processed.size());
+
+    return processed;
+}
+
+// Returns up to k most urgent patients without changing the list
+Vector<PatientRecord> LinkedListPatientQueue::peekTop(int k)
+{
+    STATS_TIME(PEEK_TOP);
+    Vector<PatientRecord> top;
+
+    for (PatientNode *curr = front; curr != nullptr && top.size() < k; curr = curr->next)
+    {
+        PatientRecord patient;
+        patient.name = curr->name;
+        patient.priority = curr->priority;
+        top.add(patient);
+    }
+
+    return top;
+}
+
 // Modifies the priority of a given existing patient in the queue.
 // Throws string exception if the given patient is present in the queue and already
 // has a more urgent priority than the given new priority.
 // Throws string exception if the given patient is not already in the queue
 void LinkedListPatientQueue::upgradePatient(string name, int newPriority)
 {
+    STATS_TIME(UPGRADE_PATIENT);
     if (isEmpty())
         throw upgradeNoPatientExceptStr(name, newPriority);
 
     if (front->name == name) // check front node
     {
+        STATS_SEARCH(1);
         if (front->priority <= newPriority)
             throw upgradeWrongPriorityExceptStr(name, newPriority, front->priority);
         front->priority = newPriority;
@@ -136,6 +236,7 @@ void LinkedListPatientQueue::upgradePatient(string name, int newPriority)
         toUpgrade->priority = newPriority;
 
         // find a new place for the node
+        STATS_COMPARE();
         if (newPriority < front->priority) // insert at front
         {
             toUpgrade->next = front;
@@ -151,10 +252,44 @@ void LinkedListPatientQueue::upgradePatient(string name, int newPriority)
     }
 }
 
+// Removes the most urgent patient with the given name from the queue.
+// Throws string exception if the given patient is not in the queue
+void LinkedListPatientQueue::removePatient(string name)
+{
+    STATS_TIME(REMOVE_PATIENT);
+    if (isEmpty())
+        throw removeNoPatientExceptStr(name);
+
+    PatientNode *toDelete;
+
+    if (front->name == name) // check front node
+    {
+        STATS_SEARCH(1);
+        toDelete = front;
+        front = front->next;
+    }
+    else
+    {
+        // find the node preceding the node with this name
+        PatientNode *found = findBeforeName(name);
+
+        if (found == nullptr) // no patient
+            throw removeNoPatientExceptStr(name);
+
+        // unlink node
+        toDelete = found->next;
+        found->next = toDelete->next;
+    }
+
+    pool->release(toDelete);
+    STATS_LEAVE(1);
+}
+
 // Returns string representation of the queue
 // in the form of "{priority1:value1, priority2:value2}"
 string LinkedListPatientQueue::toString()
 {
+    STATS_TIME(TO_STRING);
     if (isEmpty())
         return "{}";
 
@@ -173,18 +308,48 @@ string LinkedListPatientQueue::toString()
     return str.str();
 }
 
+// Returns pool the nodes come from
+const PatientNodePool &LinkedListPatientQueue::nodePool() const
+{
+    return *pool;
+}
+
+// Takes a node for the patient from the pool,
+// counting the chunks the pool allocates for it
+PatientNode *LinkedListPatientQueue::newNode(string name, int priority, PatientNode *next)
+{
+#if PATIENTQUEUE_STATS
+    long long chunks = pool->chunkAllocations();
+    long long bytes = pool->chunkBytes();
+#endif
+
+    PatientNode *node = pool->allocate(move(name), priority, next);
+
+#if PATIENTQUEUE_STATS
+    counters.allocations += pool->chunkAllocations() - chunks;
+    counters.bytesReserved += pool->chunkBytes() - bytes;
+#endif
+    return node;
+}
+
 // Finds a node preceding the node with this name
 // Returns found node or nullptr if not found
-PatientNode *LinkedListPatientQueue::findBeforeName(string name)
+PatientNode *LinkedListPatientQueue::findBeforeName(const string &name)
 {
     PatientNode *curr = front; // set iterator to the first node
+    int visited = 1;           // the front node was checked by the caller
 
     for (; curr->next != nullptr; curr = curr->next)
     {
+        ++visited;
         if (curr->next->name == name) // check next node
+        {
+            STATS_SEARCH(visited);
             return curr;
+        }
     }
 
+    STATS_SEARCH(visited);
     return nullptr;
 }
 
@@ -196,46 +361,10 @@ PatientNode *LinkedListPatientQueue::findBeforePriority(int priority)
 
     for (; curr->next != nullptr; curr = curr->next)
     {
+        STATS_COMPARE();
         if (curr->next->priority > priority) // check next node
             break;
     }
 
     return curr;
 }
-
-string LinkedListPatientQueue::processPatientExceptStr()
-{
-    return "A patient can not be processed: the queue is empty.";
-}
-
-string LinkedListPatientQueue::frontNameExceptStr()
-{
-    return "Function frontName() failed: the queue is empty.";
-}
-
-string LinkedListPatientQueue::frontPriorityExceptStr()
-{
-    return "Function frontPriority() failed: the queue is empty.";
-}
-
-string LinkedListPatientQueue::upgradeWrongPriorityExceptStr(string name, int newPriority, int currPriority)
-{
-    stringstream str;
-    str << "Function upgradePatient(" << name;
-    str << ", " << newPriority << ") failed: ";
-    str << "current prioritet " << currPriority;
-    str << " is more urgent than new prioritet " << newPriority;
-    str << ".\n";
-
-    return str.str();
-}
-
-string LinkedListPatientQueue::upgradeNoPatientExceptStr(string name, int newPriority)
-{
-    stringstream str;
-    str << "Function upgradePatient(" << name;
-    str << ", " << newPriority << ") failed: ";
-    str << "there is no patient with that name.\n";
-
-    return str.str();
-}
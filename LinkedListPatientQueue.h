@@ -0,0 +1,51 @@
+/*
+ * LinkedListPatientQueue.h
+ *
+ * This file declares the LinkedListPatientQueue class, a patient queue
+ * implemented as a singly linked list sorted by priority.
+ * Nodes come from a PatientNodePool, either the queue's own one
+ * or one shared with other queues.
+ */
+
+#ifndef _linkedlistpatientqueue_h
+#define _linkedlistpatientqueue_h
+
+#include <iostream>
+#include <string>
+#include "patientnode.h"
+#include "PatientNodePool.h"
+#include "patientqueue.h"
+
+class LinkedListPatientQueue : public PatientQueue {
+public:
+    LinkedListPatientQueue();
+    // the queue uses the given pool, which must outlive the queue
+    explicit LinkedListPatientQueue(PatientNodePool* sharedPool);
+    ~LinkedListPatientQueue();
+    std::string frontName();
+    void clear();
+    int frontPriority();
+    bool isEmpty();
+    void newPatient(std::string name, int priority);
+    void newPatients(const Vector<PatientRecord>& patients);
+    std::string processPatient();
+    Vector<std::string> processPatients(int k);
+    Vector<PatientRecord> peekTop(int k);
+    void upgradePatient(std::string name, int newPriority);
+    void removePatient(std::string name);
+    std::string toString();
+
+    // pool the nodes come from, for allocation metrics
+    const PatientNodePool& nodePool() const;
+
+private:
+    PatientNode *front;
+    PatientNodePool *pool;
+    bool ownsPool;
+
+    PatientNode *newNode(std::string name, int priority, PatientNode *next = nullptr);
+    PatientNode *findBeforeName(const std::string &name);
+    PatientNode *findBeforePriority(int priority);
+};
+
+#endif // _linkedlistpatientqueue_h
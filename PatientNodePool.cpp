@@ -0,0 +1,154 @@
+/*
+ * PatientNodePool.cpp
+ *
+ * This file implements the members of the PatientNodePool class.
+ */
+
+#include "PatientNodePool.h"
+
+using namespace std;
+
+// Constructor. Creates empty pool, chunks are allocated on demand
+PatientNodePool::PatientNodePool()
+    : nextChunk(FIRST_CHUNK), freeList(nullptr), fresh(nullptr), freshEnd(nullptr),
+      chunksAllocated(0), bytesAllocated(0), requests(0), reused(0), inUse(0), peakInUse(0)
+{
+}
+
+// Destructor. Frees all chunks
+PatientNodePool::~PatientNodePool()
+{
+    clear();
+}
+
+// Returns a node with the given fields, recycled if possible
+PatientNode *PatientNodePool::allocate(const string &name, int priority, PatientNode *next)
+{
+    PatientNode *node = take();
+
+    // a recycled node keeps its string buffer, so short names are not reallocated
+    node->name = name;
+    node->priority = priority;
+    node->next = next;
+
+    return node;
+}
+
+// Returns a node with the given fields, the name is moved in
+PatientNode *PatientNodePool::allocate(string &&name, int priority, PatientNode *next)
+{
+    PatientNode *node = take();
+
+    node->name = move(name);
+    node->priority = priority;
+    node->next = next;
+
+    return node;
+}
+
+// Takes a node from the free list or from the last chunk
+PatientNode *PatientNodePool::take()
+{
+    PatientNode *node;
+
+    if (freeList != nullptr) // recycle
+    {
+        node = freeList;
+        freeList = freeList->next;
+        ++reused;
+    }
+    else
+    {
+        if (fresh == freshEnd) // last chunk is used up
+        {
+            PatientNode *chunk = new PatientNode[nextChunk];
+            chunks.push_back(chunk);
+            ++chunksAllocated;
+            bytesAllocated += nextChunk * sizeof(PatientNode);
+
+            fresh = chunk;
+            freshEnd = chunk + nextChunk;
+
+            if (nextChunk < MAX_CHUNK)
+                nextChunk *= 2;
+        }
+        node = fresh++;
+    }
+
+    ++requests;
+    if (++inUse > peakInUse)
+        peakInUse = inUse;
+
+    return node;
+}
+
+// Takes the node back for reuse
+void PatientNodePool::release(PatientNode *node)
+{
+    node->next = freeList;
+    freeList = node;
+    --inUse;
+}
+
+// Takes back the whole list starting at front
+void PatientNodePool::releaseList(PatientNode *front)
+{
+    if (front == nullptr)
+        return;
+
+    // find the last node, then put the whole list in front of the free list
+    PatientNode *last = front;
+    --inUse;
+    for (; last->next != nullptr; last = last->next)
+        --inUse;
+
+    last->next = freeList;
+    freeList = front;
+}
+
+// Frees all chunks at once
+void PatientNodePool::clear()
+{
+    for (PatientNode *chunk: chunks)
+        delete[] chunk;
+
+    chunks.clear();
+    nextChunk = FIRST_CHUNK;
+    freeList = fresh = freshEnd = nullptr;
+    inUse = 0;
+}
+
+int PatientNodePool::chunkCount() const
+{
+    return chunks.size();
+}
+
+long long PatientNodePool::chunkAllocations() const
+{
+    return chunksAllocated;
+}
+
+long long PatientNodePool::chunkBytes() const
+{
+    return bytesAllocated;
+}
+
+long long PatientNodePool::nodeRequests() const
+{
+    return requests;
+}
+
+long long PatientNodePool::nodesReused() const
+{
+    return reused;
+}
+
+int PatientNodePool::nodesInUse() const
+{
+    return inUse;
+}
+
+int PatientNodePool::peakNodesInUse() const
+{
+    return peakInUse;
+}
@@ -0,0 +1,83 @@
+/*
+ * PatientNodePool.h
+ *
+ * This file declares the PatientNodePool class, which hands out PatientNode
+ * structures for linked list queues. Nodes are allocated in contiguous
+ * chunks and recycled through a free list instead of being deleted, so
+ * queues that add and process patients all the time do not call new and
+ * delete for every patient. A pool may be shared by several queues of the
+ * same thread; it is not thread-safe.
+ */
+
+#ifndef _patientnodepool_h
+#define _patientnodepool_h
+
+#include <string>
+#include <vector>
+#include "patientnode.h"
+
+class PatientNodePool {
+public:
+    PatientNodePool();
+    ~PatientNodePool();
+
+    /*
+     * Returns a node with the given fields, recycled if possible.
+     */
+    PatientNode* allocate(const std::string& name, int priority, PatientNode* next = nullptr);
+
+    /*
+     * Same as above, but moves the name into the node instead of copying it.
+     */
+    PatientNode* allocate(std::string&& name, int priority, PatientNode* next = nullptr);
+
+    /*
+     * Takes the node back for reuse.
+     */
+    void release(PatientNode* node);
+
+    /*
+     * Takes back the whole list starting at front, in one splice.
+     */
+    void releaseList(PatientNode* front);
+
+    /*
+     * Frees all chunks at once. Every node handed out becomes invalid,
+     * so call it only when no queue uses the pool.
+     */
+    void clear();
+
+    // Metrics
+    int chunkCount() const;             // chunks currently allocated
+    long long chunkAllocations() const; // chunks allocated since creation
+    long long chunkBytes() const;       // bytes of those chunks
+    long long nodeRequests() const;     // calls of allocate()
+    long long nodesReused() const;      // requests served from the free list
+    int nodesInUse() const;
+    int peakNodesInUse() const;
+
+private:
+    static const int FIRST_CHUNK = 64;
+    static const int MAX_CHUNK = 4096;
+
+    std::vector<PatientNode*> chunks;
+    int nextChunk;          // size of the next chunk
+    PatientNode* freeList;  // free list linked by next
+    PatientNode* fresh;     // first never used node of the last chunk
+    PatientNode* freshEnd;  // end of the last chunk
+
+    long long chunksAllocated;
+    long long bytesAllocated;
+    long long requests;
+    long long reused;
+    int inUse;
+    int peakInUse;
+
+    PatientNode* take();
+
+    // a pool owns raw chunks, so it can not be copied
+    PatientNodePool(const PatientNodePool&);
+    PatientNodePool& operator =(const PatientNodePool&);
+};
+
+#endif // _patientnodepool_h
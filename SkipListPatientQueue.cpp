@@ -0,0 +1,373 @@
+/*
+ * SkipListPatientQueue.cpp
+ *
+ * This file implements the members of the SkipListPatientQueue class.
+ */
+
+#include "SkipListPatientQueue.h"
+
+#include <algorithm>
+#include <new>
+#include <sstream>
+
+using namespace std;
+
+// Constructor. Creates empty list
+SkipListPatientQueue::SkipListPatientQueue()
+    : head(newNode(MAX_LEVEL)), level(1), timestamp(0), generator(106)
+{
+    head->priority = 0;
+    head->timestamp = 0;
+}
+
+// Destructor. Frees the memory allocated for nodes
+SkipListPatientQueue::~SkipListPatientQueue()
+{
+    clear();
+    deleteNode(head);
+}
+
+// Removes all elements from the patient queue
+void SkipListPatientQueue::clear()
+{
+    STATS_TIME(CLEAR);
+    STATS_LEAVE_ALL();
+
+    // every node is on the lowest level
+    SkipNode *curr = head->next()[0];
+    while (curr != nullptr)
+    {
+        SkipNode *toDelete = curr;
+        curr = curr->next()[0];
+        deleteNode(toDelete);
+    }
+
+    fill(head->next(), head->next() + MAX_LEVEL, nullptr);
+    level = 1;
+    timestamp = 0;
+    index.clear();
+}
+
+// Returns the name of the most urgent patient.
+// Throws string exception if the queue does not contain any patients.
+string SkipListPatientQueue::frontName()
+{
+    STATS_TIME(FRONT_NAME);
+    if (isEmpty())
+        throw frontNameExceptStr();
+    return head->next()[0]->name;
+}
+
+// Returns the integer priority of the most urgent patient
+// Throws string exception if the queue does not contain any patients.
+int SkipListPatientQueue::frontPriority()
+{
+    STATS_TIME(FRONT_PRIORITY);
+    if (isEmpty())
+        throw frontPriorityExceptStr();
+    return head->next()[0]->priority;
+}
+
+// Returns true if your patient queue does not contain any elements
+// and false if it does contain at least one patient.
+bool SkipListPatientQueue::isEmpty()
+{
+    return (head->next()[0] == nullptr);
+}
+
+// Adds the given person into the patient queue with the given priority.
+void SkipListPatientQueue::newPatient(string name, int priority)
+{
+    STATS_TIME(NEW_PATIENT);
+    STATS_ARRIVE();
+    insert(move(name), priority);
+}
+
+// Adds all given patients in order.
+void SkipListPatientQueue::newPatients(const Vector<PatientRecord>& patients)
+{
+    STATS_TIME(NEW_PATIENTS);
+    for (const auto &patient: patients)
+    {
+        STATS_ARRIVE();
+        insert(patient.name, patient.priority);
+    }
+}
+
+// Removes the patient with the most urgent priority from the queue,
+// and you returns their name as a string.
+// Throws string exception if the queue does not contain any patients.
+string SkipListPatientQueue::processPatient()
+{
+    STATS_TIME(PROCESS_PATIENT);
+    if (isEmpty())
+        throw processPatientExceptStr();
+
+    // the first node is first on all of its levels, so no search is needed
+    SkipNode *toDelete = head->next()[0];
+    for (int i = 0; i < toDelete->height; ++i)
+        head->next()[i] = toDelete->next()[i];
+
+    while (level > 1 && head->next()[level - 1] == nullptr)
+        --level;
+
+    indexRemove(toDelete);
+    string name = move(toDelete->name);
+    deleteNode(toDelete);
+    STATS_LEAVE(1);
+
+    return name;
+}
+
+// Removes up to k most urgent patients and returns their names in order.
+// They are the first k nodes, so the head is linked past them on every level
+// once instead of after each node.
+Vector<string> SkipListPatientQueue::processPatients(int k)
+{
+    STATS_TIME(PROCESS_PATIENTS);
+    Vector<string> processed;
+
+    SkipNode *curr = head->next()[0];
+    while (curr != nullptr && processed.size() < k)
+    {
+        // every node of the prefix is first on its levels at the moment it is reached
+        for (int i = 0; i < curr->height; ++i)
+            head->next()[i] = curr->next()[i];
+
+        SkipNode *toDelete = curr;
+        curr = curr->next()[0];
+
+        indexRemove(toDelete);
+        processed.add(string());
+        processed[processed.size() - 1] = move(toDelete->name);
+        deleteNode(toDelete);
+    }
+
+    while (level > 1 && head->next()[level - 1] == nullptr)
+        --level;
+    STATS_LEAVE(processed.size());
+
+    return processed;
+}
+
+// Returns up to k most urgent patients without changing the list
+Vector<PatientRecord> SkipListPatientQueue::peekTop(int k)
+{
+    STATS_TIME(PEEK_TOP);
+    Vector<PatientRecord> top;
+
+    for (SkipNode *curr = head->next()[0]; curr != nullptr && top.size() < k; curr = curr->next()[0])
+    {
+        PatientRecord patient;
+        patient.name = curr->name;
+        patient.priority = curr->priority;
+        top.add(patient);
+    }
+
+    return top;
+}
+
+// Modifies the priority of a given existing patient in the queue.
+// Throws string exception if the given patient is present in the queue and already
+// has a more urgent priority than the given new priority.
+// Throws string exception if the given patient is not already in the queue
+void SkipListPatientQueue::upgradePatient(string name, int newPriority)
+{
+    STATS_TIME(UPGRADE_PATIENT);
+    auto iter = index.find(name);
+    STATS_SEARCH(iter == index.end() ? 0 : iter->second.size());
+
+    if (iter == index.end())
+        throw upgradeNoPatientExceptStr(name, newPriority);
+
+    // as in the linked list, the first node with this name is upgraded
+    SkipNode *found = iter->second[0];
+    for (SkipNode *node: iter->second)
+    {
+        if (compare(node, found))
+            found = node;
+    }
+
+    if (found->priority <= newPriority)
+        throw upgradeWrongPriorityExceptStr(name, newPriority, found->priority);
+
+    // move the patient behind all patients with the new priority,
+    // reusing the node and its index entry
+    unlink(found);
+    found->priority = newPriority;
+    found->timestamp = ++timestamp;
+    link(found);
+}
+
+// Removes the most urgent patient with the given name from the queue.
+// Throws string exception if the given patient is not in the queue
+void SkipListPatientQueue::removePatient(string name)
+{
+    STATS_TIME(REMOVE_PATIENT);
+    auto iter = index.find(name);
+    STATS_SEARCH(iter == index.end() ? 0 : iter->second.size());
+
+    if (iter == index.end())
+        throw removeNoPatientExceptStr(name);
+
+    SkipNode *found = iter->second[0];
+    for (SkipNode *node: iter->second)
+    {
+        if (compare(node, found))
+            found = node;
+    }
+
+    unlink(found);
+    indexRemove(found);
+    deleteNode(found);
+    STATS_LEAVE(1);
+}
+
+// Returns string representation of the queue
+// in the form of "{priority1:value1, priority2:value2}"
+string SkipListPatientQueue::toString()
+{
+    STATS_TIME(TO_STRING);
+    if (isEmpty())
+        return "{}";
+
+    stringstream str;
+
+    SkipNode *iter = head->next()[0];
+
+    str << "{" << iter->priority << ":" << iter->name;
+
+    for (iter = iter->next()[0]; iter != nullptr; iter = iter->next()[0])
+    {
+        str << ", " << iter->priority << ":" << iter->name;
+    }
+    str << "}";
+
+    return str.str();
+}
+
+// Allocates a node with its next pointers in one block,
+// all of them nullptr
+SkipListPatientQueue::SkipNode *SkipListPatientQueue::newNode(int height)
+{
+    size_t bytes = sizeof(SkipNode) + height * sizeof(SkipNode *);
+    SkipNode *node = new (::operator new(bytes)) SkipNode;
+    node->height = height;
+    fill(node->next(), node->next() + height, nullptr);
+    STATS_ALLOC(bytes);
+    return node;
+}
+
+// Frees a node allocated by newNode()
+void SkipListPatientQueue::deleteNode(SkipNode *node)
+{
+    node->~SkipNode();
+    ::operator delete(node);
+}
+
+// Creates a node for the patient and links it behind
+// all nodes with priority less than or equal to given
+void SkipListPatientQueue::insert(string name, int priority)
+{
+    SkipNode *node = newNode(randomLevel());
+    node->name = move(name);
+    node->priority = priority;
+    node->timestamp = ++timestamp;
+
+    link(node);
+    index[node->name].push_back(node);
+}
+
+// Links the node on each of its levels behind all nodes that go before it
+void SkipListPatientQueue::link(SkipNode *node)
+{
+    SkipNode *before[MAX_LEVEL];
+    findBefore(node->priority, node->timestamp, before);
+
+    if (node->height > level)
+    {
+        for (int i = level; i < node->height; ++i)
+            before[i] = head;
+        level = node->height;
+    }
+
+    for (int i = 0; i < node->height; ++i)
+    {
+        node->next()[i] = before[i]->next()[i];
+        before[i]->next()[i] = node;
+    }
+}
+
+// Unlinks the node from all of its levels
+void SkipListPatientQueue::unlink(SkipNode *node)
+{
+    SkipNode *before[MAX_LEVEL];
+    findBefore(node->priority, node->timestamp, before);
+
+    for (int i = 0; i < node->height; ++i)
+        before[i]->next()[i] = node->next()[i];
+
+    while (level > 1 && head->next()[level - 1] == nullptr)
+        --level;
+}
+
+// Finds on every level the last node that goes before
+// a node with given priority and timestamp
+void SkipListPatientQueue::findBefore(int priority, int timestamp, SkipNode *before[])
+{
+    SkipNode *curr = head;
+
+    // go right on the top level, then step down a level
+    for (int i = level - 1; i >= 0; --i)
+    {
+        SkipNode *next;
+        while ((next = curr->next()[i]) != nullptr
+               && (next->priority < priority
+                   || (next->priority == priority && next->timestamp < timestamp)))
+        {
+            STATS_COMPARE();
+            curr = next;
+        }
+        STATS_COMPARE(); // the one that stopped the walk
+        before[i] = curr;
+    }
+}
+
+// Returns number of levels for a new node:
+// one more level with probability 1/2, up to MAX_LEVEL
+int SkipListPatientQueue::randomLevel()
+{
+    unsigned int bits = generator();
+    int height = 1;
+    while ((bits & 1) && height < MAX_LEVEL)
+    {
+        ++height;
+        bits >>= 1;
+    }
+    return height;
+}
+
+// compare two nodes: by priority, then by order of arrival
+bool SkipListPatientQueue::compare(const SkipNode *n1, const SkipNode *n2)
+{
+    STATS_COMPARE();
+
+    if (n1->priority != n2->priority)
+        return n1->priority < n2->priority;
+
+    return n1->timestamp < n2->timestamp;
+}
+
+// Removes the node from the name index
+void SkipListPatientQueue::indexRemove(SkipNode *node)
+{
+    auto iter = index.find(node->name);
+    if (iter == index.end())
+        return;
+
+    vector<SkipNode *> &nodes = iter->second;
+    nodes.erase(find(nodes.begin(), nodes.end(), node));
+
+    if (nodes.empty())
+        index.erase(iter);
+}
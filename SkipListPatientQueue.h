@@ -0,0 +1,71 @@
+/*
+ * SkipListPatientQueue.h
+ *
+ * This file declares the SkipListPatientQueue class, a patient queue
+ * implemented as a skip list sorted like LinkedListPatientQueue: by priority,
+ * then by order of arrival. Processing takes the first node as in the linked
+ * list, but new and upgraded patients find their place in O(log n) expected
+ * time through the express lanes of the skip list.
+ */
+
+#ifndef _skiplistpatientqueue_h
+#define _skiplistpatientqueue_h
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "patientqueue.h"
+
+class SkipListPatientQueue : public PatientQueue {
+public:
+    SkipListPatientQueue();
+    ~SkipListPatientQueue();
+    std::string frontName();
+    void clear();
+    int frontPriority();
+    bool isEmpty();
+    void newPatient(std::string name, int priority);
+    void newPatients(const Vector<PatientRecord>& patients);
+    std::string processPatient();
+    Vector<std::string> processPatients(int k);
+    Vector<PatientRecord> peekTop(int k);
+    void upgradePatient(std::string name, int newPriority);
+    void removePatient(std::string name);
+    std::string toString();
+
+private:
+    static const int MAX_LEVEL = 24;
+
+    // The next pointers of a node, one for every level, follow it
+    // in the same allocation
+    struct SkipNode
+    {
+        std::string name;
+        int priority;
+        int timestamp; // order of arrival, used to break ties
+        int height;    // number of levels of the node
+
+        SkipNode **next() { return reinterpret_cast<SkipNode **>(this + 1); }
+    };
+
+    SkipNode *head; // sentinel node with MAX_LEVEL levels
+    int level;      // number of levels in use
+    int timestamp;
+    std::mt19937 generator;
+    // patient name -> nodes with that name
+    std::unordered_map<std::string, std::vector<SkipNode*>> index;
+
+    SkipNode *newNode(int height);
+    void deleteNode(SkipNode *node);
+    void insert(std::string name, int priority);
+    void link(SkipNode *node);
+    void unlink(SkipNode *node);
+    void findBefore(int priority, int timestamp, SkipNode *before[]);
+    int randomLevel();
+    bool compare(const SkipNode *n1, const SkipNode *n2);
+    void indexRemove(SkipNode *node);
+};
+
+#endif // _skiplistpatientqueue_h
@@ -6,13 +6,14 @@
 
 #include "VectorPatientQueue.h"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
 
 // Constructor. Creates empty queue
 VectorPatientQueue::VectorPatientQueue()
-    : pq(), timestamp(0)
+    : pq(), timestamp(0), urgent(NOT_FOUND)
 {
 }
 
@@ -24,28 +25,33 @@ VectorPatientQueue::~VectorPatientQueue()
 // Removes all elements from the patient queue
 void VectorPatientQueue::clear()
 {
+    STATS_TIME(CLEAR);
     pq.clear(); // just clear Vector
+    keys.clear();
     timestamp = 0;
+    urgent = NOT_FOUND;
 }
 
 // Returns the name of the most urgent patient.
 // Throws string exception if the queue does not contain any patients.
 string VectorPatientQueue::frontName()
 {
+    STATS_TIME(FRONT_NAME);
     if (isEmpty())
             throw frontNameExceptStr();
 
-    return pq[findMostUrgent()].name;
+    return pq[mostUrgent()].name;
 }
 
 // Returns the integer priority of the most urgent patient
 // Throws string exception if the queue does not contain any patients.
 int VectorPatientQueue::frontPriority()
 {
+    STATS_TIME(FRONT_PRIORITY);
     if (isEmpty())
             throw frontPriorityExceptStr();
 
-    return pq[findMostUrgent()].priority;
+    return pq[mostUrgent()].priority;
 }
 
 // Returns true if your patient queue does not contain any elements
@@ -58,11 +64,36 @@ bool VectorPatientQueue::isEmpty()
 // Adds the given person into the patient queue with the given priority.
 void VectorPatientQueue::newPatient(string name, int priority)
 {
-    Patient patient;
-    patient.name = name;
+    STATS_TIME(NEW_PATIENT);
+    STATS_DEPTH(pq.size());
+
+    // Vector can only copy elements in,
+    // so add an empty patient and move the name into it
+    pq.push_back(Patient());
+    Patient &patient = pq[pq.size() - 1];
+    patient.name = move(name);
     patient.priority = priority;
     patient.timestamp = ++timestamp;
-    pq.push_back(patient);
+
+    added(pq.size() - 1);
+}
+
+// Adds all given patients in order.
+// The vector is not kept sorted, so patients are just appended in one pass.
+void VectorPatientQueue::newPatients(const Vector<PatientRecord>& patients)
+{
+    STATS_TIME(NEW_PATIENTS);
+    Patient patient;
+    for (const auto &record: patients)
+    {
+        STATS_DEPTH(pq.size());
+        patient.name = record.name;
+        patient.priority = record.priority;
+        patient.timestamp = ++timestamp;
+        pq.push_back(patient);
+
+        added(pq.size() - 1);
+    }
 }
 
 // Removes the patient with the most urgent priority from the queue,
@@ -70,25 +101,85 @@ void VectorPatientQueue::newPatient(string name, int priority)
 // Throws string exception if the queue does not contain any patients.
 string VectorPatientQueue::processPatient()
 {
+    STATS_TIME(PROCESS_PATIENT);
     if (isEmpty())
         throw processPatientExceptStr();
 
-    int urgent = findMostUrgent();
+    int found = mostUrgent();
 
-    string name = pq[urgent].name;
-
-    pq.remove(urgent);
+    string name = move(pq[found].name);
+    removeAt(found);
 
     return name;
 }
 
+// Removes up to k most urgent patients and returns their names in order.
+// The patients are found in one pass, and the rest of the vector
+// is closed up once instead of after every removed patient.
+Vector<string> VectorPatientQueue::processPatients(int k)
+{
+    STATS_TIME(PROCESS_PATIENTS);
+    vector<int> found = findMostUrgent(k);
+
+    Vector<string> processed;
+    vector<bool> removed(pq.size(), false);
+    for (int i: found)
+    {
+        processed.add(string());
+        processed[processed.size() - 1] = move(pq[i].name);
+        removed[i] = true;
+    }
+
+    int size = 0;
+    for (int i = 0; i < pq.size(); ++i)
+    {
+        if (!removed[i])
+        {
+            if (size != i)
+            {
+                pq[size] = move(pq[i]);
+                keys[size] = keys[i];
+                STATS_MOVE();
+            }
+            ++size;
+        }
+    }
+
+    // removing from the back does not shift anything
+    while (pq.size() > size)
+        pq.remove(pq.size() - 1);
+    keys.resize(size);
+    urgent = NOT_FOUND;
+
+    return processed;
+}
+
+// Returns up to k most urgent patients without changing the queue
+Vector<PatientRecord> VectorPatientQueue::peekTop(int k)
+{
+    STATS_TIME(PEEK_TOP);
+    Vector<PatientRecord> top;
+
+    for (int i: findMostUrgent(k))
+    {
+        PatientRecord patient;
+        patient.name = pq[i].name;
+        patient.priority = pq[i].priority;
+        top.add(patient);
+    }
+
+    return top;
+}
+
 // Modifies the priority of a given existing patient in the queue.
 // Throws string exception if the given patient is present in the queue and already
 // has a more urgent priority than the given new priority.
 // Throws string exception if the given patient is not already in the queue
 void VectorPatientQueue::upgradePatient(string name, int newPriority)
 {
+    STATS_TIME(UPGRADE_PATIENT);
     int found = findName(name);
+    STATS_SEARCH(pq.size());
 
     if (found == NOT_FOUND)
         throw upgradeNoPatientExceptStr(name, newPriority);
@@ -99,12 +190,33 @@ void VectorPatientQueue::upgradePatient(string name, int newPriority)
     // upgrade
     pq[found].priority = newPriority;
     pq[found].timestamp = ++timestamp;
+    keys[found] = keyOf(newPriority, timestamp);
+
+    // the upgraded patient may overtake the cached one
+    STATS_COMPARE();
+    if (urgent != NOT_FOUND && keys[found] < keys[urgent])
+        urgent = found;
+}
+
+// Removes the most urgent patient with the given name from the queue.
+// Throws string exception if the given patient is not in the queue
+void VectorPatientQueue::removePatient(string name)
+{
+    STATS_TIME(REMOVE_PATIENT);
+    int found = findName(name);
+    STATS_SEARCH(pq.size());
+
+    if (found == NOT_FOUND)
+        throw removeNoPatientExceptStr(name);
+
+    removeAt(found);
 }
 
 // Returns string representation of the queue
 // in the form of "{priority1:value1, priority2:value2}"
 string VectorPatientQueue::toString()
 {
+    STATS_TIME(TO_STRING);
    if (isEmpty())
        return "{}";
 
@@ -127,28 +239,104 @@ string VectorPatientQueue::toString()
    return str.str();
 }
 
+// Packs priority and timestamp so that keys compare
+// by priority, then by timestamp
+long long VectorPatientQueue::keyOf(int priority, int timestamp)
+{
+    return static_cast<long long>(priority) * (1LL << 32) + timestamp;
+}
+
+// Records key of the patient just added at index
+// and keeps the cached most urgent patient up to date
+void VectorPatientQueue::added(int index)
+{
+    STATS_GROWTH(keys, keys.push_back(keyOf(pq[index].priority, pq[index].timestamp)));
+    STATS_COMPARE();
+
+    if (pq.size() == 1)
+        urgent = index;
+    else if (urgent != NOT_FOUND && keys[index] < keys[urgent])
+        urgent = index;
+}
+
+// Removes patient at index. The vector is not sorted, so the last patient
+// takes its place instead of shifting all patients after it.
+void VectorPatientQueue::removeAt(int index)
+{
+    int last = pq.size() - 1;
+    if (index != last)
+    {
+        pq[index] = move(pq[last]);
+        keys[index] = keys[last];
+        STATS_MOVE();
+    }
+    pq.remove(last);
+    keys.pop_back();
+
+    if (urgent == index)
+        urgent = NOT_FOUND; // found again when it is needed
+    else if (urgent == last)
+        urgent = index;
+}
+
+// Returns index of most urgent patient, scans only if it is not cached
+int VectorPatientQueue::mostUrgent()
+{
+    if (urgent == NOT_FOUND)
+        urgent = findMostUrgent();
+    return urgent;
+}
+
 // Returns index of most urgent patient
 int VectorPatientQueue::findMostUrgent()
 {
-    int found = 0;
-    // find element with the smallest priority
+    // the smallest key is found first, in a loop without branches
+    // that the compiler turns into SIMD min instructions,
+    // then a second pass finds where it is; keys are unique
+    long long smallest = keys[0];
+    for (size_t i = 1; i < keys.size(); ++i)
+        smallest = keys[i] < smallest ? keys[i] : smallest;
+    STATS_COMPARES(keys.size() - 1);
+
+    return find(keys.begin(), keys.end(), smallest) - keys.begin();
+}
+
+// Returns indexes of up to k most urgent patients, most urgent first.
+// One pass over the vector keeps the k best seen so far in a heap
+// whose top is the least urgent of them.
+vector<int> VectorPatientQueue::findMostUrgent(int k)
+{
+    auto moreUrgent = [this](int i1, int i2) {
+        STATS_COMPARE();
+        return keys[i1] < keys[i2];
+    };
+
+    vector<int> best;
+    if (k <= 0)
+        return best;
+    best.reserve(min(k, pq.size()));
+
     for (int i = 0; i < pq.size(); ++i)
     {
-        // if priorities is equal then compare timestamps
-        if (pq[i].priority == pq[found].priority)
+        if (static_cast<int>(best.size()) < k)
         {
-            if (pq[i].timestamp < pq[found].timestamp)
-                found = i;
+            best.push_back(i);
+            push_heap(best.begin(), best.end(), moreUrgent);
+        }
+        else if (moreUrgent(i, best.front()))
+        {
+            pop_heap(best.begin(), best.end(), moreUrgent);
+            best.back() = i;
+            push_heap(best.begin(), best.end(), moreUrgent);
         }
-        else if (pq[i].priority < pq[found].priority)
-            found = i;
     }
 
-    return found;
+    sort_heap(best.begin(), best.end(), moreUrgent);
+    return best;
 }
 
 // Returns index by patient name or -1 if not found
-int VectorPatientQueue::findName(string name)
+int VectorPatientQueue::findName(const string &name)
 {
     int found = NOT_FOUND;
 
@@ -176,40 +364,3 @@ int VectorPatientQueue::findName(string name)
 
     return found;
 }
-
-string VectorPatientQueue::processPatientExceptStr()
-{
-    return "A patient can not be processed: the queue is empty.";
-}
-
-string VectorPatientQueue::frontNameExceptStr()
-{
-    return "Function frontName() failed: the queue is empty.";
-}
-
-string VectorPatientQueue::frontPriorityExceptStr()
-{
-    return "Function frontPriority() failed: the queue is empty.";
-}
-
-string VectorPatientQueue::upgradeWrongPriorityExceptStr(string name, int newPriority, int currPriority)
-{
-    stringstream str;
-    str << "Function upgradePatient(" << name;
-    str << ", " << newPriority << ") failed: ";
-    str << "current prioritet " << currPriority;
-    str << " is more urgent than new prioritet " << newPriority;
-    str << ".\n";
-
-    return str.str();
-}
-
-string VectorPatientQueue::upgradeNoPatientExceptStr(string name, int newPriority)
-{
-    stringstream str;
-    str << "Function upgradePatient(" << name;
-    str << ", " << newPriority << ") failed: ";
-    str << "there is no patient with that name.\n";
-
-    return str.str();
-}
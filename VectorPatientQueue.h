@@ -0,0 +1,62 @@
+/*
+ * VectorPatientQueue.h
+ *
+ * This file declares the VectorPatientQueue class, a patient queue
+ * implemented as an unsorted Vector of patients. The index of the most
+ * urgent patient is cached until a patient is processed, and the scan
+ * that finds it again reads a separate contiguous array of keys.
+ */
+
+#ifndef _vectorpatientqueue_h
+#define _vectorpatientqueue_h
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "patientqueue.h"
+#include "vector.h"
+
+class VectorPatientQueue : public PatientQueue {
+public:
+    VectorPatientQueue();
+    ~VectorPatientQueue();
+    std::string frontName();
+    void clear();
+    int frontPriority();
+    bool isEmpty();
+    void newPatient(std::string name, int priority);
+    void newPatients(const Vector<PatientRecord>& patients);
+    std::string processPatient();
+    Vector<std::string> processPatients(int k);
+    Vector<PatientRecord> peekTop(int k);
+    void upgradePatient(std::string name, int newPriority);
+    void removePatient(std::string name);
+    std::string toString();
+
+private:
+    static const int NOT_FOUND = -1;
+
+    struct Patient
+    {
+        std::string name;
+        int priority;
+        int timestamp; // order of arrival, used to break ties
+    };
+
+    Vector<Patient> pq;
+    // (priority, timestamp) of every patient packed in one number, in the
+    // same order as pq, so the smallest key belongs to the most urgent patient
+    std::vector<long long> keys;
+    int timestamp;
+    int urgent; // index of the most urgent patient, NOT_FOUND if not known
+
+    static long long keyOf(int priority, int timestamp);
+    void added(int index);
+    void removeAt(int index);
+    int mostUrgent();
+    int findMostUrgent();
+    std::vector<int> findMostUrgent(int k);
+    int findName(const std::string &name);
+};
+
+#endif // _vectorpatientqueue_h
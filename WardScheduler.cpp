@@ -0,0 +1,179 @@
+/*
+ * WardScheduler.cpp
+ *
+ * This file implements the members of the WardScheduler class.
+ */
+
+#include "WardScheduler.h"
+
+#include <thread>
+
+using namespace std;
+
+// Constructor. Creates the given number of empty wards
+// Throws string exception if there are no wards.
+WardScheduler::WardScheduler(int wards, int maxInversion)
+    : numberOfWards(wards), maxInversion(maxInversion), count(0), stolen(0), takenCount(0), inversion(0)
+{
+    if (wards < 1)
+        throw string("WardScheduler: there must be at least one ward.");
+
+    this->wards.reset(new Ward[wards]);
+}
+
+// Destructor. Wards free their heaps themselves
+WardScheduler::~WardScheduler()
+{
+}
+
+int WardScheduler::wardCount() const
+{
+    return numberOfWards;
+}
+
+// Returns true if no ward has a waiting patient
+bool WardScheduler::isEmpty() const
+{
+    return (count == 0);
+}
+
+// Returns the number of waiting patients in all wards
+int WardScheduler::size() const
+{
+    return count;
+}
+
+// Adds the patient to the given ward
+void WardScheduler::newPatient(int ward, string name, int priority)
+{
+    Ward &target = wards[ward];
+
+    lock_guard<mutex> guard(target.lock);
+    target.queue.newPatient(move(name), priority);
+    updateTop(target);
+    ++target.size;
+    ++count;
+}
+
+// Takes the next patient for the worker of the given ward.
+// Returns false if there is nobody the worker may take.
+bool WardScheduler::nextPatient(int ward, string &name, int &priority, int &fromWard)
+{
+    while (count > 0)
+    {
+        long long best;
+        int victim = findVictim(ward, best);
+
+        if (victim < 0)
+        {
+            if (maxInversion < 0)
+                return false; // the own ward is empty
+
+            // the last patients are being taken, their tops are not updated yet
+            this_thread::yield();
+            continue;
+        }
+
+        if (takeFrom(victim, best, name, priority))
+        {
+            fromWard = victim;
+            if (victim != ward)
+                ++stolen;
+            ++takenCount;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+long long WardScheduler::steals() const
+{
+    return stolen;
+}
+
+long long WardScheduler::taken() const
+{
+    return takenCount;
+}
+
+int WardScheduler::largestInversion() const
+{
+    return inversion;
+}
+
+// Returns the ward the worker of own should take a patient from,
+// or -1 if there is none, and sets best to the most urgent front priority.
+// The own ward is kept unless another front is more urgent by more than
+// maxInversion; of equal fronts the one of the busiest ward is stolen.
+int WardScheduler::findVictim(int own, long long &best)
+{
+    long long ownTop = wards[own].top;
+
+    if (maxInversion < 0)
+    {
+        best = ownTop;
+        return (ownTop == EMPTY) ? -1 : own;
+    }
+
+    int found = -1;
+    best = EMPTY;
+    for (int i = 0; i < numberOfWards; ++i)
+    {
+        long long top = wards[i].top;
+        if (top == EMPTY)
+            continue;
+
+        if (top < best || (top == best && wards[i].size > wards[found].size))
+        {
+            found = i;
+            best = top;
+        }
+    }
+
+    if (found < 0)
+        return -1;
+
+    if (ownTop != EMPTY && ownTop <= best + maxInversion)
+        return own;
+
+    return found;
+}
+
+// Takes the front patient of the victim ward, unless the ward was emptied
+// or its front got worse than the bound since the tops were read.
+// Returns true if a patient was taken.
+bool WardScheduler::takeFrom(int victim, long long best, string &name, int &priority)
+{
+    Ward &ward = wards[victim];
+
+    lock_guard<mutex> guard(ward.lock);
+    if (ward.queue.isEmpty())
+        return false;
+
+    priority = ward.queue.frontPriority();
+    if (maxInversion >= 0 && priority > best + maxInversion)
+        return false; // look at the tops again
+
+    name = ward.queue.processPatient();
+    updateTop(ward);
+    --ward.size;
+    --count;
+
+    // remember the largest inversion, another thread may raise it meanwhile
+    int seen = static_cast<int>(priority - best);
+    int largest = inversion;
+    while (seen > largest && !inversion.compare_exchange_weak(largest, seen))
+    {
+        // compare again with the value another thread stored
+    }
+
+    return true;
+}
+
+// Publishes front priority of the ward for findVictim()
+// Ward must be locked
+void WardScheduler::updateTop(Ward &ward)
+{
+    ward.top = ward.queue.isEmpty() ? EMPTY : ward.queue.frontPriority();
+}
@@ -0,0 +1,83 @@
+/*
+ * WardScheduler.h
+ *
+ * This file declares the WardScheduler class, which spreads patients over
+ * several wards, each one a HeapPatientQueue with its own lock and its own
+ * worker thread. A worker takes patients from its own ward, and steals the
+ * most urgent patient of another ward when its own ward is empty or when
+ * the other patient is more urgent by more than maxInversion priorities.
+ *
+ * So a worker never takes a patient that is less urgent than the most
+ * urgent waiting patient by more than maxInversion, as seen by the front
+ * priorities the wards publish. Larger bounds let workers stay with their
+ * own ward more often, which keeps the locks of other wards free.
+ */
+
+#ifndef _wardscheduler_h
+#define _wardscheduler_h
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "HeapPatientQueue.h"
+
+class WardScheduler {
+public:
+    // maxInversion below zero turns stealing off: workers take only
+    // patients of their own ward
+    static const int NO_STEALING = -1;
+
+    // Throws string exception if there are no wards.
+    explicit WardScheduler(int wards, int maxInversion = 0);
+    ~WardScheduler();
+
+    int wardCount() const;
+    bool isEmpty() const;
+    int size() const;
+
+    // Adds the patient to the given ward
+    void newPatient(int ward, std::string name, int priority);
+
+    // Takes the next patient for the worker of the given ward and returns
+    // true, or returns false if there is nobody to take. Sets fromWard to
+    // the ward the patient came from, which differs from ward after a steal.
+    bool nextPatient(int ward, std::string& name, int& priority, int& fromWard);
+
+    // Metrics
+    long long steals() const;        // patients taken from another ward
+    long long taken() const;         // patients taken in total
+    int largestInversion() const;    // largest priority inversion seen
+                                     // when a patient was taken
+
+private:
+    static const long long EMPTY = 1LL << 40; // top of an empty ward
+
+    struct Ward
+    {
+        std::mutex lock;
+        HeapPatientQueue queue;
+        std::atomic<long long> top; // front priority, read without the lock
+        std::atomic<int> size;      // patients waiting, read without the lock
+
+        Ward() : top(EMPTY), size(0) {}
+    };
+
+    int numberOfWards;
+    int maxInversion;
+    std::unique_ptr<Ward[]> wards;
+    std::atomic<int> count;
+    std::atomic<long long> stolen;
+    std::atomic<long long> takenCount;
+    std::atomic<int> inversion;
+
+    int findVictim(int own, long long &best);
+    bool takeFrom(int victim, long long best, std::string &name, int &priority);
+    void updateTop(Ward &ward);
+
+    // the wards hold locks, so a scheduler can not be copied
+    WardScheduler(const WardScheduler&);
+    WardScheduler& operator =(const WardScheduler&);
+};
+
+#endif // _wardscheduler_h
@@ -6,33 +6,44 @@
 
 #include "encoding.h"
 
+#include <algorithm>
+#include <memory>
+#include <vector>
 #include "pqueue.h"
 #include "filelib.h"
 #include "HuffmanNode.h"
+#include "FlatHuffmanTree.h"
+#include "encodingmodes.h"
+#include "huffmantables.h"
 
 // Function prototypes
 void buildCode(HuffmanNode* node, Map<int, string> &encodingMap, string code = "");
-void writeCode(const string& code, obitstream& output);
 bool isLeaf(HuffmanNode* node);
 
 // This function reads input from a given istream
 // and builds frequency table for all characters in the file
 Map<int, int> buildFrequencyTable(istream& input)
 {
-    // create empty map
-    Map<int, int> freqTable;
-    int key;
-    // read input until EOF
-    while((key = input.get()) != EOF)
+    // count in a flat array while reading chunks,
+    // looking up the map for every byte is slow;
+    // chunks start small and double while the input fills them,
+    // up to the size that is counted on several threads
+    size_t size = 1 << 16;
+    unique_ptr<char[]> chunk(new char[size]);
+    uint64_t counts[256] = {};
+    while (input)
     {
-        // get value for current key from the map
-        int value = freqTable.get(key);
-        // put key back to the map with value increased by 1
-        freqTable.put(key, value + 1);
+        input.read(chunk.get(), size);
+        countBytes(chunk.get(), input.gcount(), counts);
+        if (static_cast<size_t>(input.gcount()) == size && size < PARALLEL_COUNT_BYTES)
+        {
+            size *= 2;
+            chunk.reset(new char[size]);
+        }
     }
-    // finally add PSEUDO_EOF key
-    freqTable.put(PSEUDO_EOF, 1);
-    return freqTable;
+
+    // then create the map of the characters in the file and PSEUDO_EOF
+    return frequencyTable(counts);
 }
 
 // Accepts a frequency table and use it to create a Huffman encoding tree
@@ -89,98 +100,105 @@ Map<int, string> buildEncodingMap(HuffmanNode* encodingTree)
     return encodingMap;
 }
 
-// Reads one character at a time from a given input file,
+// Reads the given input file in chunks,
 // and use the provided encoding map to encode each character to binary,
 // then write the character's encoded binary bits to the given bit output bit stream.
 void encodeData(istream& input, const Map<int, string>& encodingMap, obitstream& output)
 {
-    int key;
-    // read input until EOF
-    while((key = input.get()) != EOF)
-    {
-        // get string represented code for current character from the encoding map
-        string code = encodingMap.get(key);
-        writeCode(code, output);
-
-    }
-    // write PSEUDO_EOF code at the end
-    string code = encodingMap.get(PSEUDO_EOF);
-    writeCode(code, output);
+    // the codes are packed into integers and appended to a 64-bit buffer,
+    // so neither the map nor writeBit() is called per character
+    EncodeTable table(encodingMap);
+    table.encode(input, output);
 }
 
-// Reads bits from the given input file one at a time,
-// and recursively walk through the specified decoding tree to write
+// Reads bits from the given input file many at a time,
+// and looks them up in tables built from the decoding tree to write
 // the original uncompressed contents of that file to the given output stream.
 void decodeData(ibitstream& input, HuffmanNode* encodingTree, ostream& output)
 {
-    int bit;
-    HuffmanNode* curr = encodingTree; // current position in the tree
-    while (true)
-    {
-        bit = input.readBit(); // read one bit
-
-        // move on the tree, depending on the bit value
-        if (bit == 0)
-            curr = curr->zero;
-        else if (bit == 1)
-            curr = curr->one;
-
-        // if leaf is reached
-        if (isLeaf(curr))
-        {
-            // each leaf contains real character
-            int ch = curr->character;
-
-            // break if PSEUDO_EOF is reached
-            if (ch == PSEUDO_EOF)
-                break;
-
-            // write character to output
-            output << static_cast<char>(ch);
-            // reset tree for next traversal
-            curr = encodingTree;
-        }
-    }
+    // the tables give the character and the length of its code in one probe,
+    // so the tree is not walked one bit at a time
+    DecodeTable table(encodingTree);
+    BitReader reader(input);
+    table.decode(reader, output);
 }
 
 // Compresses the given input file into the given output file.
+// The header holds the code lengths, see huffmantables.h, and the data
+// is written with the canonical codes of those lengths.
+// The input is read twice, so it must be a file; compressStream() of
+// encodingmodes.h reads it once.
+// See encodingmodes.h for the other ways to compress.
 void compress(istream& input, obitstream& output)
 {
     // Create frequency table from input file
     Map<int, int> freqTable = buildFrequencyTable(input);
-    // write it to output
-    output << freqTable;
-    // rewind stream
+    // build encoding tree from frequenncy table, in one array
+    FlatHuffmanTree encodingTree(freqTable);
+    // only the length of each code is needed
+    int lengths[PSEUDO_EOF + 1];
+    codeLengths(encodingTree.root(), lengths);
+    // rare characters of skewed inputs would get long codes
+    limitCodeLengths(freqTable, CODE_LENGTH_LIMIT, lengths);
+
+    // write header to output
+    output.write(CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC));
+    output.put(static_cast<char>(CANONICAL_CONTAINER));
+    writeCodeLengths(output, lengths);
+
+    // rewind stream and encode data
     rewindStream(input);
-    // build encoding tree from frequenncy table
-    HuffmanNode* encodingTree = buildEncodingTree(freqTable);
-    // build encoding map from encoding tree
-    Map<int, string> encodingMap = buildEncodingMap(encodingTree);
-    // destroy tree
-    freeTree(encodingTree);
-
-    // encode data
-    encodeData(input, encodingMap, output);
+    EncodeTable table(lengths);
+    table.encode(input, output);
 }
 
-// Read the bits from the given input file one at a time,
-// including header packed inside the start of the file,
+// Reads the header packed inside the start of the given input file,
+// then decodes the bits after it,
 // to write the original contents of that file to the file specified by the output parameter.
+// Files of the first version, with the frequency table as header, are read as well.
+// Throws string exception for a container version it does not know.
 void decompress(ibitstream& input, ostream& output)
 {
+    if (input.peek() == CONTAINER_MAGIC[0])
+    {
+        char magic[sizeof(CONTAINER_MAGIC)];
+        input.read(magic, sizeof(magic));
+        int version = input.get();
+        if (!equal(magic, magic + sizeof(magic), CONTAINER_MAGIC)
+                || (version != CANONICAL_CONTAINER && version != BLOCK_CONTAINER
+                    && version != STREAM_CONTAINER))
+            throw string("decompress: unknown container version.");
+
+        if (version == BLOCK_CONTAINER)
+        {
+            decompressBlocks(input, output);
+            return;
+        }
+        if (version == STREAM_CONTAINER)
+        {
+            decompressStream(input, output);
+            return;
+        }
+
+        // the tables are built from the code lengths, without a tree
+        int lengths[PSEUDO_EOF + 1];
+        readCodeLengths(input, lengths);
+        DecodeTable table(lengths);
+        BitReader reader(input);
+        table.decode(reader, output);
+        return;
+    }
+
     // create empty frequenncy table
     Map<int, int> freqTable;
     // read table from input file
     input >> freqTable;
-    // build encoding tree from frequenncy table
-    HuffmanNode* encodingTree = buildEncodingTree(freqTable);
+    // build encoding tree from frequenncy table, in one array
+    FlatHuffmanTree encodingTree(freqTable);
     // decode data
-    decodeData(input, encodingTree, output);
-    // destroy tree
-    freeTree(encodingTree);
+    decodeData(input, encodingTree.root(), output);
 }
 
-
 // Frees the memory associated with the tree whose root node is represented by the given pointer.
 void freeTree(HuffmanNode* node)
 {
@@ -213,16 +231,6 @@ void buildCode(HuffmanNode *node, Map<int, string> &encodingMap, string code)
         buildCode(node->one, encodingMap, code + "1");
 }
 
-// Writes binary string code to the bit stream
-void writeCode(const string &code, obitstream &output)
-{
-    // convert each digit to integer and write it to the bit stream
-    for (const auto &c: code)
-    {
-        output.writeBit(static_cast<int>(c - '0'));
-    }
-}
-
 // Returns true if node is leaf node
 bool isLeaf(HuffmanNode *node)
 {
@@ -0,0 +1,595 @@
+/*
+ * encodingmodes.cpp
+ *
+ * This file implements the functions of encodingmodes.h and the members
+ * of the BlockContainer class.
+ */
+
+#include "encodingmodes.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include "bitstream.h"
+#include "encoding.h"
+#include "FlatHuffmanTree.h"
+#include "huffmantables.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/*
+ * A whole input file in memory: mapped where mmap() exists, read into
+ * a string otherwise. Unmapped when the object is destroyed.
+ */
+class MappedInput {
+public:
+    const char* data;
+    size_t size;
+
+    // Throws string exception if the file can not be read
+    explicit MappedInput(const string& file);
+    ~MappedInput();
+
+private:
+    string whole;
+    void* mapped;
+
+    MappedInput(const MappedInput&);
+    MappedInput& operator =(const MappedInput&);
+};
+
+/*
+ * An output file of a known size, mapped for writing where mmap() exists,
+ * a buffer written to the file by finish() otherwise.
+ */
+class MappedOutput {
+public:
+    char* data;
+    size_t size;
+
+    // Creates or truncates the file to the size.
+    // Throws string exception if it can not be created.
+    MappedOutput(const string& file, size_t size);
+    ~MappedOutput();
+
+    // Makes the data the contents of the file.
+    // Throws string exception if it can not be written.
+    void finish();
+
+private:
+    string file;
+    vector<char> buffer;
+    void* mapped;
+
+    MappedOutput(const MappedOutput&);
+    MappedOutput& operator =(const MappedOutput&);
+};
+
+// Function prototypes
+static size_t compressBatch(istream& input, vector<char>& batch, size_t blockSize, vector<string>& compressed);
+static string compressBlock(const char* data, size_t size);
+static void dataCodeLengths(const char* data, size_t size, int lengths[PSEUDO_EOF + 1]);
+static void decompressBlockData(const char* data, size_t length, char* out, size_t size);
+static size_t maxCompressedSize(size_t size);
+static void runParallel(int count, const function<void(int)>& work);
+static int batchBlocks();
+static void putNumber(ostream& output, uint64_t value, int bytes);
+static uint64_t getNumber(const char* data, int bytes);
+static uint64_t readNumber(istream& input, int bytes);
+
+// Reads a batch of blocks, compresses them in parallel and writes them in
+// order, so only one batch is in memory. Writes the index at the end.
+void compressBlocks(istream& input, ostream& output, size_t blockSize)
+{
+    if (blockSize == 0 || blockSize > UINT32_MAX)
+        throw string("compressBlocks: the block size must be from 1 byte to 4 GiB.");
+
+    output.write(CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC));
+    output.put(static_cast<char>(BLOCK_CONTAINER));
+    putNumber(output, blockSize, 4);
+
+    vector<char> batch(batchBlocks() * blockSize);
+    vector<string> compressed;
+    vector<uint64_t> offsets;
+    vector<uint32_t> sizes;
+    uint64_t offset = 0;
+    size_t got;
+    while ((got = compressBatch(input, batch, blockSize, compressed)) > 0)
+    {
+        for (size_t block = 0; block < compressed.size(); ++block)
+        {
+            offsets.push_back(offset);
+            sizes.push_back(min(blockSize, got - block * blockSize));
+            output.write(compressed[block].data(), compressed[block].size());
+            offset += compressed[block].size();
+        }
+    }
+
+    for (size_t block = 0; block < offsets.size(); ++block)
+    {
+        putNumber(output, offsets[block], 8);
+        putNumber(output, sizes[block], 4);
+    }
+    putNumber(output, offsets.size(), 4);
+    putNumber(output, offset, 8);
+}
+
+// Reads the rest of the input, as the index is at its end
+void decompressBlocks(istream& input, ostream& output)
+{
+    string data((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+    BlockContainer container(data.data(), data.size());
+    container.decompressAll(output);
+}
+
+// Writes every batch of chunks as soon as it is compressed,
+// each chunk after its sizes, then a chunk of size 0
+void compressStream(istream& input, ostream& output, size_t chunkSize)
+{
+    if (chunkSize == 0 || chunkSize > MAX_STREAM_CHUNK)
+        throw string("compressStream: the chunk size must be from 1 byte to 1 GiB.");
+
+    output.write(CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC));
+    output.put(static_cast<char>(STREAM_CONTAINER));
+    putNumber(output, chunkSize, 4);
+
+    vector<char> batch(batchBlocks() * chunkSize);
+    vector<string> compressed;
+    size_t got;
+    while ((got = compressBatch(input, batch, chunkSize, compressed)) > 0)
+    {
+        for (size_t chunk = 0; chunk < compressed.size(); ++chunk)
+        {
+            putNumber(output, min(chunkSize, got - chunk * chunkSize), 4);
+            putNumber(output, compressed[chunk].size(), 4);
+            output.write(compressed[chunk].data(), compressed[chunk].size());
+        }
+    }
+    putNumber(output, 0, 4);
+}
+
+// Reads a batch of chunks, decompresses them in parallel and writes them
+// in order. The chunk size in the header bounds the memory of a batch.
+void decompressStream(istream& input, ostream& output)
+{
+    const string truncated = "decompressStream: the stream is truncated.";
+    const string damaged = "decompressStream: a chunk header is damaged.";
+    size_t chunkSize = readNumber(input, 4);
+    if (chunkSize == 0 || chunkSize > MAX_STREAM_CHUNK)
+        throw damaged;
+
+    int batch = batchBlocks();
+    vector<string> compressed(batch);
+    vector<size_t> starts(batch + 1, 0);
+    vector<char> out;
+    bool last = false;
+    while (!last)
+    {
+        int chunks = 0;
+        while (chunks < batch)
+        {
+            size_t size = readNumber(input, 4);
+            if (size == 0)
+            {
+                last = true;
+                break;
+            }
+            size_t length = readNumber(input, 4);
+            if (size > chunkSize || length > maxCompressedSize(size))
+                throw damaged;
+
+            compressed[chunks].resize(length);
+            if (!input.read(&compressed[chunks][0], length))
+                throw truncated;
+            starts[chunks + 1] = starts[chunks] + size;
+            ++chunks;
+        }
+
+        out.resize(starts[chunks]);
+        runParallel(chunks, [&](int chunk) {
+            decompressBlockData(compressed[chunk].data(), compressed[chunk].size(),
+                                out.data() + starts[chunk], starts[chunk + 1] - starts[chunk]);
+        });
+        output.write(out.data(), starts[chunks]);
+    }
+}
+
+// Counts and encodes the mapped input in place, as compress() does
+// with two passes over its stream
+void compressFile(const string& inputFile, const string& outputFile)
+{
+    MappedInput input(inputFile);
+    int lengths[PSEUDO_EOF + 1];
+    dataCodeLengths(input.data, input.size, lengths);
+
+    ofstream output(outputFile.c_str(), ios::binary | ios::trunc);
+    if (!output)
+        throw string("compressFile: can not write " + outputFile + ".");
+    output.write(CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC));
+    output.put(static_cast<char>(CANONICAL_CONTAINER));
+    writeCodeLengths(output, lengths);
+
+    EncodeTable table(lengths);
+    BitWriter writer(output);
+    BitSink sink = writer.begin();
+    table.encode(writer, sink, input.data, input.size);
+    table.encodeSymbol(writer, sink, PSEUDO_EOF);
+    writer.finish(sink);
+    if (!output.flush())
+        throw string("compressFile: can not write " + outputFile + ".");
+}
+
+// Decodes the mapped input in place. Block containers are decoded
+// straight into the mapped output, every block on its own thread.
+// The other versions go through decompress().
+void decompressFile(const string& inputFile, const string& outputFile)
+{
+    MappedInput input(inputFile);
+    const char* data = input.data + sizeof(CONTAINER_MAGIC) + 1;
+    size_t size = input.size - min(input.size, sizeof(CONTAINER_MAGIC) + 1);
+    int version = -1;
+    if (input.size > sizeof(CONTAINER_MAGIC)
+            && memcmp(input.data, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC)) == 0)
+        version = static_cast<unsigned char>(input.data[sizeof(CONTAINER_MAGIC)]);
+
+    if (version == BLOCK_CONTAINER)
+    {
+        BlockContainer container(data, size);
+        vector<size_t> starts(container.blockCount() + 1, 0);
+        for (int block = 0; block < container.blockCount(); ++block)
+            starts[block + 1] = starts[block] + container.blockSize(block);
+
+        MappedOutput output(outputFile, starts.back());
+        runParallel(container.blockCount(), [&](int block) {
+            container.decompressBlock(block, output.data + starts[block]);
+        });
+        output.finish();
+        return;
+    }
+
+    ofstream output(outputFile.c_str(), ios::binary | ios::trunc);
+    if (!output)
+        throw string("decompressFile: can not write " + outputFile + ".");
+
+    if (version == CANONICAL_CONTAINER)
+    {
+        int lengths[PSEUDO_EOF + 1];
+        size_t header = readCodeLengths(data, size, lengths);
+        DecodeTable table(lengths);
+        BitReader reader(data + header, size - header);
+        table.decode(reader, output);
+    }
+    else
+    {
+        ifbitstream stream(inputFile);
+        decompress(stream, output);
+    }
+
+    if (!output.flush())
+        throw string("decompressFile: can not write " + outputFile + ".");
+}
+
+// Constructor. Checks that the index fits the container exactly and that
+// no block is larger than the block size of the header, or its compressed
+// data larger than compressBlock() can write, before anything is allocated
+BlockContainer::BlockContainer(const char* data, size_t size)
+    : data(data), size(size)
+{
+    const string damaged = "BlockContainer: the block index is damaged.";
+    if (size < 4 + 12)
+        throw damaged;
+
+    uint64_t blockSize = getNumber(data, 4);
+    if (blockSize == 0)
+        throw damaged;
+
+    uint64_t count = getNumber(data + size - 12, 4);
+    uint64_t indexOffset = getNumber(data + size - 8, 8);
+    if (indexOffset > size || 4 + indexOffset + 12 * count + 12 != size)
+        throw damaged;
+
+    const char* index = data + 4 + indexOffset;
+    for (uint64_t block = 0; block < count; ++block)
+    {
+        offsets.push_back(getNumber(index + 12 * block, 8));
+        sizes.push_back(getNumber(index + 12 * block + 8, 4));
+        if (offsets.back() > indexOffset || (block > 0 && offsets.back() < offsets[block - 1]))
+            throw damaged;
+    }
+    offsets.push_back(indexOffset);
+
+    for (uint64_t block = 0; block < count; ++block)
+    {
+        if (sizes[block] > blockSize || offsets[block + 1] - offsets[block] > maxCompressedSize(sizes[block]))
+            throw damaged;
+    }
+}
+
+int BlockContainer::blockCount() const
+{
+    return sizes.size();
+}
+
+size_t BlockContainer::blockSize(int block) const
+{
+    return sizes[block];
+}
+
+size_t BlockContainer::totalSize() const
+{
+    size_t total = 0;
+    for (uint32_t blockSize: sizes)
+        total += blockSize;
+    return total;
+}
+
+void BlockContainer::decompressBlock(int block, char* out) const
+{
+    decompressBlockData(data + 4 + offsets[block], offsets[block + 1] - offsets[block], out, sizes[block]);
+}
+
+// Decompresses a batch of blocks at a time, so only one batch is in memory
+void BlockContainer::decompressAll(ostream& output) const
+{
+    int batch = batchBlocks();
+    vector<char> out;
+    for (int first = 0; first < blockCount(); first += batch)
+    {
+        int blocks = min(batch, blockCount() - first);
+        vector<size_t> starts(blocks + 1, 0);
+        for (int i = 0; i < blocks; ++i)
+            starts[i + 1] = starts[i] + sizes[first + i];
+        out.resize(starts[blocks]);
+
+        runParallel(blocks, [&](int i) {
+            decompressBlock(first + i, out.data() + starts[i]);
+        });
+        output.write(out.data(), starts[blocks]);
+    }
+}
+
+// Reads up to one batch of blocks of the input and compresses them
+// in parallel into compressed. Returns the number of bytes read.
+static size_t compressBatch(istream& input, vector<char>& batch, size_t blockSize, vector<string>& compressed)
+{
+    input.read(batch.data(), batch.size());
+    size_t got = input.gcount();
+    compressed.assign((got + blockSize - 1) / blockSize, string());
+    runParallel(compressed.size(), [&](int block) {
+        size_t begin = block * blockSize;
+        compressed[block] = compressBlock(batch.data() + begin, min(blockSize, got - begin));
+    });
+    return got;
+}
+
+// Compresses the block with its own code lengths.
+// Returns the lengths and the codes.
+static string compressBlock(const char* data, size_t size)
+{
+    int lengths[PSEUDO_EOF + 1];
+    dataCodeLengths(data, size, lengths);
+
+    ostringstream output;
+    writeCodeLengths(output, lengths);
+    EncodeTable table(lengths);
+    BitWriter writer(output);
+    BitSink sink = writer.begin();
+    table.encode(writer, sink, data, size);
+    table.encodeSymbol(writer, sink, PSEUDO_EOF);
+    writer.finish(sink);
+    return output.str();
+}
+
+// Sets the code lengths of the characters in memory, as compress() does
+static void dataCodeLengths(const char* data, size_t size, int lengths[PSEUDO_EOF + 1])
+{
+    uint64_t counts[256] = {};
+    countBytes(data, size, counts);
+    FlatHuffmanTree encodingTree(counts);
+    codeLengths(encodingTree.root(), lengths);
+
+    // the frequency table is only needed if a code is too long
+    if (*max_element(lengths, lengths + PSEUDO_EOF + 1) > CODE_LENGTH_LIMIT)
+        limitCodeLengths(frequencyTable(counts), CODE_LENGTH_LIMIT, lengths);
+}
+
+// Decompresses a block written by compressBlock() into out,
+// which has room for its original size
+static void decompressBlockData(const char* data, size_t length, char* out, size_t size)
+{
+    int lengths[PSEUDO_EOF + 1];
+    size_t header = readCodeLengths(data, length, lengths);
+    DecodeTable table(lengths);
+    BitReader reader(data + header, length - header);
+    table.decode(reader, out, size);
+}
+
+// Returns the most bytes compressBlock() writes for size characters:
+// the code lengths, and codes no longer on average than the 8 and 9 bit
+// codes that fit all symbols
+static size_t maxCompressedSize(size_t size)
+{
+    return (PSEUDO_EOF + 1) + (9 * (size + 1) + 7) / 8;
+}
+
+// Runs work(i) for every i below count on as many threads as there are
+// cores, each thread taking the next i when it is done with one.
+// Rethrows the first string exception of work after all threads ended.
+static void runParallel(int count, const function<void(int)>& work)
+{
+    int threads = min<int>(count, max(1u, thread::hardware_concurrency()));
+    atomic<int> next(0);
+    string error;
+    mutex errorLock;
+
+    auto worker = [&]() {
+        for (int i = next++; i < count; i = next++)
+        {
+            try
+            {
+                work(i);
+            }
+            catch (const string& e)
+            {
+                lock_guard<mutex> guard(errorLock);
+                if (error.empty())
+                    error = e;
+            }
+        }
+    };
+
+    // this thread works as well
+    vector<thread> pool;
+    for (int t = 1; t < threads; ++t)
+        pool.push_back(thread(worker));
+    worker();
+    for (thread& t: pool)
+        t.join();
+
+    if (!error.empty())
+        throw error;
+}
+
+// Returns how many blocks to keep in memory at a time,
+// two for every core so no thread waits for the slowest one long
+static int batchBlocks()
+{
+    return 2 * max(1u, thread::hardware_concurrency());
+}
+
+// Writes the lowest bytes of the value, lowest byte first
+static void putNumber(ostream& output, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+        output.put(static_cast<char>(value >> (8 * i)));
+}
+
+// Reads a number written by putNumber() from memory
+static uint64_t getNumber(const char* data, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i)
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+    return value;
+}
+
+// Reads a number written by putNumber() from the stream.
+// Throws string exception if the stream ends first.
+static uint64_t readNumber(istream& input, int bytes)
+{
+    char data[8];
+    if (!input.read(data, bytes))
+        throw string("decompressStream: the stream is truncated.");
+    return getNumber(data, bytes);
+}
+
+MappedInput::MappedInput(const string& file)
+    : data(nullptr), size(0), mapped(nullptr)
+{
+    const string error = "MappedInput: can not read " + file + ".";
+#ifdef _WIN32
+    ifstream input(file.c_str(), ios::binary);
+    if (!input)
+        throw error;
+    whole.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+    data = whole.data();
+    size = whole.size();
+#else
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw error;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        throw error;
+    }
+
+    // an empty file can not be mapped
+    size = info.st_size;
+    if (size != 0)
+    {
+        mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            close(fd);
+            throw error;
+        }
+        madvise(mapped, size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapped);
+    }
+    close(fd);
+#endif
+    if (data == nullptr)
+        data = whole.data();
+}
+
+MappedInput::~MappedInput()
+{
+#ifndef _WIN32
+    if (mapped != nullptr)
+        munmap(mapped, size);
+#endif
+}
+
+MappedOutput::MappedOutput(const string& file, size_t size)
+    : data(nullptr), size(size), file(file), mapped(nullptr)
+{
+    const string error = "MappedOutput: can not write " + file + ".";
+#ifdef _WIN32
+    buffer.resize(size);
+    data = buffer.data();
+#else
+    int fd = open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        throw error;
+
+    if (size != 0)
+    {
+        if (ftruncate(fd, size) != 0)
+        {
+            close(fd);
+            throw error;
+        }
+        mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            close(fd);
+            throw error;
+        }
+        data = static_cast<char*>(mapped);
+    }
+    close(fd);
+#endif
+}
+
+MappedOutput::~MappedOutput()
+{
+#ifndef _WIN32
+    if (mapped != nullptr)
+        munmap(mapped, size);
+#endif
+}
+
+void MappedOutput::finish()
+{
+#ifdef _WIN32
+    ofstream output(file.c_str(), ios::binary | ios::trunc);
+    if (!output.write(buffer.data(), buffer.size()))
+        throw string("MappedOutput: can not write " + file + ".");
+#endif
+}
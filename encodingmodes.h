@@ -0,0 +1,112 @@
+/*
+ * encodingmodes.h
+ *
+ * This file declares the ways to compress besides compress() of
+ * encoding.h, and the container versions all of them write. decompress()
+ * reads every version.
+ *
+ * A compressed file starts with CONTAINER_MAGIC and a version byte, or
+ * with '{' if it is of the first version, which stored the frequency table.
+ *
+ * Block containers split the input into blocks, each with its own code
+ * lengths, so blocks are compressed and decompressed on several threads:
+ *
+ *   u32 block size
+ *   blocks: code lengths, then the codes of the block and of PSEUDO_EOF,
+ *           filled up to a whole byte
+ *   index: for every block its u64 offset and its u32 original size
+ *   u32 number of blocks, u64 offset of the index
+ *
+ * Stream containers hold chunks compressed the same way, each after its
+ * sizes, so they are written and read in one pass, as on a pipe:
+ *
+ *   u32 chunk size
+ *   chunks: u32 original size, u32 compressed size, then the chunk as a block
+ *   u32 0
+ *
+ * Numbers are little endian, offsets count from the first block. The index
+ * at the end lets a reader find any block without decoding the others.
+ */
+
+#ifndef _encodingmodes_h
+#define _encodingmodes_h
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+const char CONTAINER_MAGIC[] = {'H', 'U', 'F'};
+const int CANONICAL_CONTAINER = 2;  // code lengths, then the canonical codes
+const int BLOCK_CONTAINER = 3;      // blocks and their index
+const int STREAM_CONTAINER = 4;     // chunks after their sizes
+
+const size_t DEFAULT_BLOCK_SIZE = 256 << 10;
+const size_t MAX_STREAM_CHUNK = 1 << 30;
+
+// Compresses the input into a block container, one batch of blocks at a time.
+// Reads the input once, so it may be a pipe.
+void compressBlocks(std::istream& input, std::ostream& output, size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+// Decompresses a block container whose magic bytes and version were read
+// Throws string exception if it is damaged.
+void decompressBlocks(std::istream& input, std::ostream& output);
+
+// Compresses the input into a stream container in one pass, keeping one
+// batch of chunks in memory, so it works from stdin to stdout.
+// Throws string exception if the chunk size is 0 or over MAX_STREAM_CHUNK.
+void compressStream(std::istream& input, std::ostream& output, size_t chunkSize = DEFAULT_BLOCK_SIZE);
+
+// Decompresses a stream container whose magic bytes and version were read,
+// one batch of chunks at a time.
+// Throws string exception if it is damaged.
+void decompressStream(std::istream& input, std::ostream& output);
+
+// Compresses the input file into the output file as compress() does,
+// counting and encoding the mapped input in place instead of reading it
+// twice through a stream.
+// Throws string exception if a file can not be read or written.
+void compressFile(const std::string& inputFile, const std::string& outputFile);
+
+// Decompresses the input file of any version into the output file.
+// Decodes the mapped input in place, block containers straight into the
+// mapped output, on several threads.
+// Throws string exception if a file can not be read or written, or the
+// input is damaged.
+void decompressFile(const std::string& inputFile, const std::string& outputFile);
+
+/*
+ * The blocks of a block container in memory, for decompressing all of them
+ * on several threads or any one of them alone.
+ */
+class BlockContainer {
+public:
+    // Reads the index of the container, data being the bytes after the
+    // magic bytes and the version, which must outlive the object.
+    // Throws string exception if the index is damaged.
+    BlockContainer(const char* data, size_t size);
+
+    int blockCount() const;
+
+    // Returns the original size of the block
+    size_t blockSize(int block) const;
+
+    // Returns the total of the original sizes
+    size_t totalSize() const;
+
+    // Decompresses the block into out, which has room for its original size.
+    // Throws string exception if it is damaged.
+    void decompressBlock(int block, char* out) const;
+
+    // Decompresses all blocks on several threads and writes them in order
+    void decompressAll(std::ostream& output) const;
+
+private:
+    const char* data;
+    size_t size;
+    std::vector<uint64_t> offsets;  // one more than there are blocks
+    std::vector<uint32_t> sizes;
+};
+
+#endif // _encodingmodes_h
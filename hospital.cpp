@@ -20,6 +20,7 @@
 #include "random.h"
 #include "simpio.h"
 #include "vector.h"
+#include "BucketPatientQueue.h"
 #include "HeapPatientQueue.h"
 #include "VectorPatientQueue.h"
 #include "LinkedListPatientQueue.h"
@@ -33,7 +34,9 @@ static const int WIDTH = 22;                  // column width for menu output
 static std::string randomString(int maxLength);
 void test(PatientQueue& queue);
 void bulkDequeue(PatientQueue& queue, int count);
+void bulkPeek(PatientQueue& queue, int count);
 void bulkEnqueue(PatientQueue& queue, int count);
+void printStats(PatientQueue& queue);
 static void easterEgg();
 
 int main() {
@@ -45,7 +48,7 @@ int main() {
     }
 
     while (true) {
-        std::string prompt = "V)ector, L)inkedList, H)eap?";
+        std::string prompt = "V)ector, L)inkedList, H)eap, B)ucket?";
         std::string choice = toUpperCase(trim(getLine(prompt)));
         if (choice == "V") {
             VectorPatientQueue pq;
@@ -59,6 +62,10 @@ int main() {
             HeapPatientQueue pq;
             test(pq);
             break;
+        } else if (choice == "B") {
+            BucketPatientQueue pq;
+            test(pq);
+            break;
         }
     }
 
@@ -96,7 +103,7 @@ void test(PatientQueue& queue) {
             std::cout << " (not empty)" << std::endl;
         }
 
-        std::string prompt = "N)ew, F)ront, U)pgrade, P)rocess, B)ulk, C)lear, Q)uit?";
+        std::string prompt = "N)ew, F)ront, U)pgrade, P)rocess, R)emove, B)ulk, C)lear, S)tats, Q)uit?";
         std::string choice = toUpperCase(trim(getLine(prompt)));
         if (choice.empty() || choice == "Q") {
             break;
@@ -104,8 +111,13 @@ void test(PatientQueue& queue) {
             std::string value = getLine("Name? ");
             int newPriority = getInteger("New priority? ");
             queue.upgradePatient(value, newPriority);
+        } else if (choice == "R") {
+            std::string value = getLine("Name? ");
+            queue.removePatient(value);
         } else if (choice == "C") {
             queue.clear();
+        } else if (choice == "S") {
+            printStats(queue);
         } else if (choice == "P") {
             std::string value = queue.processPatient();
             std::cout << "Processing patient: \"" << value << "\"" << std::endl;
@@ -119,11 +131,13 @@ void test(PatientQueue& queue) {
             std::cout << "Front of line is \"" << name << "\" with priority " << pri << std::endl;
         } else if (choice == "B") {
             int count = getInteger("How many patients? ");
-            std::string choice2 = toUpperCase(trim(getLine("N)ew or P)rocess: ")));
+            std::string choice2 = toUpperCase(trim(getLine("N)ew, P)rocess or T)op: ")));
             if (choice2 == "N") {
                 bulkEnqueue(queue, count);
             } else if (choice2 == "P") {
                 bulkDequeue(queue, count);
+            } else if (choice2 == "T") {
+                bulkPeek(queue, count);
             }
         } else if (choice == "TNG") {
             easterEgg();
@@ -132,13 +146,23 @@ void test(PatientQueue& queue) {
 }
 
 /*
- * Dequeues the given number of patients from the queue.
+ * Dequeues the given number of patients from the queue, in one batch.
  * Helpful for bulk testing.
  */
 void bulkDequeue(PatientQueue& queue, int count) {
-    for (int i = 1; i <= count; i++) {
-        std::string value = queue.processPatient();
-        std::cout << "#" << i << ", processing patient: \"" << value << "\"" << std::endl;
+    Vector<std::string> names = queue.processPatients(count);
+    for (int i = 0; i < names.size(); i++) {
+        std::cout << "#" << (i + 1) << ", processing patient: \"" << names[i] << "\"" << std::endl;
+    }
+}
+
+/*
+ * Prints the given number of most urgent patients without removing them.
+ */
+void bulkPeek(PatientQueue& queue, int count) {
+    Vector<PatientRecord> patients = queue.peekTop(count);
+    for (int i = 0; i < patients.size(); i++) {
+        std::cout << "#" << (i + 1) << " is \"" << patients[i].name << "\" with priority " << patients[i].priority << std::endl;
     }
 }
 
@@ -149,12 +173,13 @@ void bulkDequeue(PatientQueue& queue, int count) {
  */
 void bulkEnqueue(PatientQueue& queue, int count) {
     std::string choice2 = trim(toUpperCase(getLine("R)andom, A)scending, D)escending? ")));
+    Vector<PatientRecord> patients;
     if (choice2 == "R") {
         for (int i = 0; i < count; i++) {
-            std::string value = randomString(5);
-            int priority = randomInteger(1, count);
-            queue.newPatient(value, priority);
-            std::cout << "New patient \"" << value << "\" with priority " << priority << std::endl;
+            PatientRecord patient;
+            patient.name = randomString(5);
+            patient.priority = randomInteger(1, count);
+            patients.add(patient);
         }
     } else if (choice2 == "A" || choice2 == "D") {
         Vector<std::string> toAdd;
@@ -163,20 +188,43 @@ void bulkEnqueue(PatientQueue& queue, int count) {
         }
         if (choice2 == "A") {
             for (int i = 0; i < toAdd.size(); i++) {
-                std::string value = toAdd[i];
-                int priority = i + 1;
-                queue.newPatient(value, priority);
-                std::cout << "New patient \"" << value << "\" with priority " << priority << std::endl;
+                PatientRecord patient;
+                patient.name = toAdd[i];
+                patient.priority = i + 1;
+                patients.add(patient);
             }
         } else {
             for (int i = toAdd.size() - 1; i >= 0; i--) {
-                std::string value = toAdd.get(i);
-                int priority = i + 1;
-                queue.newPatient(value, priority);
-                std::cout << "New patient \"" << value << "\" with priority " << priority << std::endl;
+                PatientRecord patient;
+                patient.name = toAdd.get(i);
+                patient.priority = i + 1;
+                patients.add(patient);
             }
         }
     }
+
+    // enqueue the whole batch at once
+    queue.newPatients(patients);
+    for (int i = 0; i < patients.size(); i++) {
+        std::cout << "New patient \"" << patients[i].name << "\" with priority " << patients[i].priority << std::endl;
+    }
+}
+
+/*
+ * Prints the work the queue has counted so far and optionally starts
+ * counting again. Statistics are compiled out of release builds.
+ */
+void printStats(PatientQueue& queue) {
+    if (!PATIENTQUEUE_STATS) {
+        std::cout << "Statistics are compiled out, build without NDEBUG"
+                  << " or with PATIENTQUEUE_STATS=1 to count them." << std::endl;
+        return;
+    }
+
+    std::cout << queue.stats();
+    if (toUpperCase(trim(getLine("R)eset or Enter? "))) == "R") {
+        queue.resetStats();
+    }
 }
 
 /*
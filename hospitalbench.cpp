@@ -0,0 +1,806 @@
+/*
+ * hospitalbench.cpp
+ *
+ * This file contains the main program for timing the patient queue
+ * implementations. Unlike hospital.cpp it prints nothing per operation,
+ * only the measured times.
+ *
+ * Without arguments it shows a menu. Workloads can also be replayed
+ * in batch mode, for example from a script comparing two builds:
+ *
+ *   hospitalbench replay FILE [QUEUES]       replays a workload file
+ *   hospitalbench mix COUNT [QUEUES] [SEED] [REMOVE%]
+ *                                            replays a generated workload
+ *   hospitalbench generate COUNT [SEED] [REMOVE%] [name|arrival]
+ *                                            writes a generated workload for
+ *                                            queues breaking ties that way
+ *   hospitalbench topk COUNT K ROUNDS [QUEUES]
+ *                                            times taking K patients at a time
+ *   hospitalbench front ROUNDS [QUEUES]      times front/process rounds
+ *   hospitalbench journal COUNT [GROUP]      times journaling and recovery
+ *   hospitalbench generic COUNT ROUNDS       times the queue template with and
+ *                                            without virtual calls
+ *   hospitalbench wards THREADS COUNT [SKEW%]
+ *                                            times the ward scheduler with and
+ *                                            without stealing
+ *
+ * QUEUES is a list of letters, see newQueue(); all queues by default.
+ * A generated mix is made twice, once for the queues breaking priority ties
+ * by name and once for those breaking them by arrival, see tieBreak().
+ * Replays warn about failed operations and then exit with status 1.
+ * Build it with NDEBUG defined, or the queues also count statistics
+ * (see queuestats.h) and every time includes that work.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "console.h"
+#include "random.h"
+#include "simpio.h"
+#include "strlib.h"
+#include "vector.h"
+#include "memorystats.h"
+#include "workload.h"
+#include "BasicPatientQueue.h"
+#include "ConcurrentPatientQueue.h"
+#include "DaryHeapPatientQueue.h"
+#include "BucketPatientQueue.h"
+#include "HeapPatientQueue.h"
+#include "JournaledPatientQueue.h"
+#include "LinkedListPatientQueue.h"
+#include "SkipListPatientQueue.h"
+#include "VectorPatientQueue.h"
+#include "WardScheduler.h"
+
+using namespace std;
+
+static const int WIDTH = 28;  // column width for result output
+static const int MAX_PRIORITY = 1000;  // priorities of generated workloads
+static const string ALL_QUEUES = "VLSHIDBCGA";
+
+// function prototype declarations
+int batch(const Vector<string>& args);
+PatientQueue* newQueue(char letter, string& name);
+TieBreak tieBreak(char letter);
+bool benchReplay(const Vector<Operation>& byName, const Vector<Operation>& byArrival, const string& queues);
+static double elapsedMs(chrono::steady_clock::time_point start);
+static void printResult(const string& label, double ms, int ops);
+void benchUpgrade(int count, int upgrades);
+double timeUpgrades(PatientQueue& queue, int count, int upgrades);
+void benchDaryHeap(int count);
+template <typename Queue>
+double timeNewAndProcess(Queue& queue, int count);
+void benchConcurrent(int maxThreads, int opsPerThread);
+void benchNodePool(int count, int rounds);
+void benchTopK(int count, int k, int rounds, const string& queues);
+double timeTopK(PatientQueue& queue, int count, int k, int rounds, char mode);
+void benchFront(int rounds, const string& queues);
+void benchJournal(int count, int groupSize);
+template <typename Queue>
+double timeFront(Queue& queue, int count, int rounds);
+void benchGeneric(int count, int rounds);
+template <typename Queue>
+void benchDevirtualized(char letter, int count, int rounds);
+double timeThreads(ConcurrentPatientQueue& queue, int threads, int opsPerThread);
+void benchWards(int threads, int count, int skew);
+void timeWards(int threads, int maxInversion, const Vector<int>& wardOf, const string& label);
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        Vector<string> args;
+        for (int i = 1; i < argc; i++) {
+            args.add(argv[i]);
+        }
+        return batch(args);
+    }
+
+    cout << "CS 106B Hospital Patient Queue Benchmarks" << endl;
+    cout << "=========================================" << endl;
+
+    while (true) {
+        cout << endl;
+        string choice = toUpperCase(trim(getLine("R)eplay, U)pgrade, D)-ary heap, C)oncurrent, N)ode pool, T)op k, F)ront, J)ournal, G)eneric, W)ards, Q)uit?")));
+        if (choice.empty() || choice == "Q") {
+            break;
+        } else if (choice == "R") {
+            string file = trim(getLine("Workload file (Enter to generate)? "));
+            Vector<Operation> byName;
+            Vector<Operation> byArrival;
+            if (file.empty()) {
+                int count = getInteger("How many operations? ");
+                int removals = getInteger("Percent of removals? ");
+                byName = generateWorkload(count, MAX_PRIORITY, 106, removals, TIES_BY_NAME);
+                byArrival = generateWorkload(count, MAX_PRIORITY, 106, removals, TIES_BY_ARRIVAL);
+            } else {
+                ifstream input(file.c_str());
+                try {
+                    byName = byArrival = loadWorkload(input);
+                } catch (const string& error) {
+                    cout << error << endl;
+                    continue;
+                }
+            }
+            string queues = toUpperCase(trim(getLine("Queues (Enter for " + ALL_QUEUES + ")? ")));
+            benchReplay(byName, byArrival, queues.empty() ? ALL_QUEUES : queues);
+        } else if (choice == "U") {
+            int count = getInteger("How many patients? ");
+            int upgrades = getInteger("How many upgrades? ");
+            benchUpgrade(count, upgrades);
+        } else if (choice == "D") {
+            int count = getInteger("How many patients? ");
+            benchDaryHeap(count);
+        } else if (choice == "C") {
+            int maxThreads = getInteger("Up to how many threads? ");
+            int ops = getInteger("How many operations per thread? ");
+            benchConcurrent(maxThreads, ops);
+        } else if (choice == "N") {
+            int count = getInteger("How many patients waiting? ");
+            int rounds = getInteger("How many process/new rounds? ");
+            benchNodePool(count, rounds);
+        } else if (choice == "T") {
+            int count = getInteger("How many patients waiting? ");
+            int k = getInteger("How many patients per batch? ");
+            int rounds = getInteger("How many batches? ");
+            string queues = toUpperCase(trim(getLine("Queues (Enter for " + ALL_QUEUES + ")? ")));
+            benchTopK(count, k, rounds, queues.empty() ? ALL_QUEUES : queues);
+        } else if (choice == "F") {
+            int rounds = getInteger("How many rounds? ");
+            string queues = toUpperCase(trim(getLine("Queues (Enter for VLH)? ")));
+            benchFront(rounds, queues.empty() ? "VLH" : queues);
+        } else if (choice == "J") {
+            int count = getInteger("How many patients? ");
+            int groupSize = getInteger("How many changes per group commit? ");
+            benchJournal(count, groupSize);
+        } else if (choice == "G") {
+            int count = getInteger("How many patients? ");
+            int rounds = getInteger("How many front/process rounds? ");
+            benchGeneric(count, rounds);
+        } else if (choice == "W") {
+            int threads = getInteger("How many wards (threads)? ");
+            int count = getInteger("How many patients? ");
+            int skew = getInteger("Percent of patients admitted to ward 0? ");
+            benchWards(threads, count, skew);
+        }
+    }
+
+    cout << endl;
+    cout << "Exiting." << endl;
+    return 0;
+}
+
+/*
+ * Runs the command given on the command line, see the top of this file.
+ * Returns exit code of the program.
+ */
+int batch(const Vector<string>& args) {
+    string command = args[0];
+    try {
+        if (command == "replay" && args.size() >= 2) {
+            ifstream input(args[1].c_str());
+            if (!input) {
+                cerr << "Can not open " << args[1] << endl;
+                return 1;
+            }
+            Vector<Operation> workload = loadWorkload(input);
+            return benchReplay(workload, workload, args.size() >= 3 ? toUpperCase(args[2]) : ALL_QUEUES) ? 0 : 1;
+        } else if (command == "mix" && args.size() >= 2) {
+            int seed = args.size() >= 4 ? stringToInteger(args[3]) : 106;
+            int removals = args.size() >= 5 ? stringToInteger(args[4]) : 0;
+            int count = stringToInteger(args[1]);
+            Vector<Operation> byName = generateWorkload(count, MAX_PRIORITY, seed, removals, TIES_BY_NAME);
+            Vector<Operation> byArrival = generateWorkload(count, MAX_PRIORITY, seed, removals, TIES_BY_ARRIVAL);
+            return benchReplay(byName, byArrival, args.size() >= 3 ? toUpperCase(args[2]) : ALL_QUEUES) ? 0 : 1;
+        } else if (command == "generate" && args.size() >= 2) {
+            int seed = args.size() >= 3 ? stringToInteger(args[2]) : 106;
+            int removals = args.size() >= 4 ? stringToInteger(args[3]) : 0;
+            TieBreak ties = args.size() >= 5 && toLowerCase(args[4]) == "arrival" ? TIES_BY_ARRIVAL : TIES_BY_NAME;
+            saveWorkload(generateWorkload(stringToInteger(args[1]), MAX_PRIORITY, seed, removals, ties), cout);
+            return 0;
+        } else if (command == "front" && args.size() >= 2) {
+            benchFront(stringToInteger(args[1]), args.size() >= 3 ? toUpperCase(args[2]) : "VLH");
+            return 0;
+        } else if (command == "journal" && args.size() >= 2) {
+            benchJournal(stringToInteger(args[1]), args.size() >= 3 ? stringToInteger(args[2]) : 64);
+            return 0;
+        } else if (command == "generic" && args.size() >= 3) {
+            benchGeneric(stringToInteger(args[1]), stringToInteger(args[2]));
+            return 0;
+        } else if (command == "wards" && args.size() >= 3) {
+            benchWards(stringToInteger(args[1]), stringToInteger(args[2]),
+                       args.size() >= 4 ? stringToInteger(args[3]) : 0);
+            return 0;
+        } else if (command == "topk" && args.size() >= 4) {
+            benchTopK(stringToInteger(args[1]), stringToInteger(args[2]), stringToInteger(args[3]),
+                      args.size() >= 5 ? toUpperCase(args[4]) : ALL_QUEUES);
+            return 0;
+        }
+    } catch (const string& error) {
+        cerr << error << endl;
+        return 1;
+    }
+
+    cerr << "Usage: hospitalbench [replay FILE [QUEUES] | mix COUNT [QUEUES] [SEED] [REMOVE%]"
+         << " | generate COUNT [SEED] [REMOVE%] [name|arrival] | topk COUNT K ROUNDS [QUEUES]"
+         << " | front ROUNDS [QUEUES] | journal COUNT [GROUP] | generic COUNT ROUNDS"
+         << " | wards THREADS COUNT [SKEW%]]" << endl;
+    return 1;
+}
+
+/*
+ * Returns a new empty queue for the given letter and sets its name,
+ * or returns nullptr if there is no such queue:
+ * V)ector, L)inkedList, S)kip list, H)eap, I)ndexed heap, D)-ary heap,
+ * B)ucket, C)oncurrent, G)eneric heap by name, A)rrival-ordered generic heap.
+ */
+PatientQueue* newQueue(char letter, string& name) {
+    switch (letter) {
+    case 'V': name = "vector"; return new VectorPatientQueue();
+    case 'L': name = "linkedlist"; return new LinkedListPatientQueue();
+    case 'S': name = "skiplist"; return new SkipListPatientQueue();
+    case 'H': name = "heap"; return new HeapPatientQueue();
+    case 'I': name = "heap-indexed"; return new HeapPatientQueue(true);
+    case 'D': name = "4-ary-heap"; return new DaryHeapPatientQueue<4>();
+    case 'B': name = "bucket"; return new BucketPatientQueue();
+    case 'C': name = "concurrent"; return new ConcurrentPatientQueue();
+    case 'G': name = "basic-by-name"; return new NameOrderedPatientQueue();
+    case 'A': name = "basic-by-arrival"; return new ArrivalOrderedPatientQueue();
+    default: return nullptr;
+    }
+}
+
+/*
+ * Returns how the queue for the given letter orders patients with
+ * equal priorities.
+ */
+TieBreak tieBreak(char letter) {
+    return string("VLSBA").find(letter) != string::npos ? TIES_BY_ARRIVAL : TIES_BY_NAME;
+}
+
+/*
+ * Replays the workload matching the tie break of each of the given queues
+ * and prints the results as tab separated columns. Returns false and warns
+ * on cerr if any operation failed, as the queue then did not follow
+ * the workload.
+ */
+bool benchReplay(const Vector<Operation>& byName, const Vector<Operation>& byArrival, const string& queues) {
+    bool ok = true;
+    printReplayHeader(cout);
+    for (char letter: queues) {
+        string name;
+        PatientQueue* queue = newQueue(letter, name);
+        if (queue == nullptr) {
+            continue;
+        }
+        ReplayResult result = replayWorkload(*queue, tieBreak(letter) == TIES_BY_ARRIVAL ? byArrival : byName);
+        printReplayResult(cout, name, result);
+        if (result.errors > 0) {
+            cerr << "warning: " << result.errors << " operations failed on " << name << endl;
+            ok = false;
+        }
+        delete queue;
+    }
+    return ok;
+}
+
+// Returns milliseconds passed since start
+static double elapsedMs(chrono::steady_clock::time_point start) {
+    chrono::duration<double, milli> ms = chrono::steady_clock::now() - start;
+    return ms.count();
+}
+
+// Prints one line of results: total time and operations per second
+static void printResult(const string& label, double ms, int ops) {
+    cout << setw(WIDTH) << left << label
+         << setw(12) << right << fixed << setprecision(2) << ms << " ms"
+         << setw(14) << right << setprecision(0) << (ops / ms * 1000.0) << " ops/s" << endl;
+}
+
+/*
+ * Compares upgradePatient() of the heap that searches for the name
+ * against the heap with the name-to-slot index.
+ */
+void benchUpgrade(int count, int upgrades) {
+    HeapPatientQueue searching;
+    HeapPatientQueue indexed(true);
+
+    printResult("heap, name search", timeUpgrades(searching, count, upgrades), upgrades);
+    printResult("heap, name index", timeUpgrades(indexed, count, upgrades), upgrades);
+}
+
+/*
+ * Fills the queue with count patients and returns the time spent in
+ * the given number of random upgrades.
+ */
+double timeUpgrades(PatientQueue& queue, int count, int upgrades) {
+    setRandomSeed(106); // the same workload for every queue
+
+    Vector<string> names;
+    Vector<int> priorities;
+    for (int i = 0; i < count; i++) {
+        names.add("patient" + integerToString(i));
+        priorities.add(randomInteger(count, 4 * count));
+        queue.newPatient(names[i], priorities[i]);
+    }
+
+    // prepare upgrades in advance, so only the queue is timed
+    Vector<int> who;
+    Vector<int> newPriorities;
+    for (int i = 0; i < upgrades; i++) {
+        int patient = randomInteger(0, count - 1);
+        priorities[patient] -= randomInteger(1, 3);
+        who.add(patient);
+        newPriorities.add(priorities[patient]);
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < upgrades; i++) {
+        queue.upgradePatient(names[who[i]], newPriorities[i]);
+    }
+    return elapsedMs(start);
+}
+
+/*
+ * Compares the binary heap of patient entries with d-ary heaps
+ * that keep priorities apart from the names.
+ */
+void benchDaryHeap(int count) {
+    HeapPatientQueue binary;
+    printResult("heap of patients", timeNewAndProcess<PatientQueue>(binary, count), 2 * count);
+
+    DaryHeapPatientQueue<2> binaryKeys;
+    printResult("2-ary heap of keys", timeNewAndProcess<PatientQueue>(binaryKeys, count), 2 * count);
+
+    DaryHeapPatientQueue<4> quaternary;
+    printResult("4-ary heap of keys", timeNewAndProcess<PatientQueue>(quaternary, count), 2 * count);
+
+    DaryHeapPatientQueue<8> octonary;
+    printResult("8-ary heap of keys", timeNewAndProcess<PatientQueue>(octonary, count), 2 * count);
+}
+
+/*
+ * Returns the time spent adding count random patients to the queue
+ * and then processing all of them.
+ */
+template <typename Queue>
+double timeNewAndProcess(Queue& queue, int count) {
+    setRandomSeed(106); // the same workload for every queue
+
+    Vector<string> names;
+    Vector<int> priorities;
+    for (int i = 0; i < count; i++) {
+        names.add("patient" + integerToString(randomInteger(0, count)));
+        priorities.add(randomInteger(1, count));
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        queue.newPatient(names[i], priorities[i]);
+    }
+    while (!queue.isEmpty()) {
+        queue.processPatient();
+    }
+    return elapsedMs(start);
+}
+
+/*
+ * Runs the same new/process mix on the concurrent queue with 1 to
+ * maxThreads threads, in strict and in relaxed mode.
+ */
+void benchConcurrent(int maxThreads, int opsPerThread) {
+    ConcurrentPatientQueue::Ordering orderings[] = {
+        ConcurrentPatientQueue::STRICT, ConcurrentPatientQueue::RELAXED
+    };
+    string labels[] = {"strict", "relaxed"};
+
+    for (int i = 0; i < 2; i++) {
+        for (int threads = 1; threads <= maxThreads; threads++) {
+            ConcurrentPatientQueue queue(orderings[i]);
+            double ms = timeThreads(queue, threads, opsPerThread);
+            printResult(labels[i] + ", " + integerToString(threads) + " threads",
+                        ms, threads * opsPerThread);
+        }
+    }
+}
+
+/*
+ * Returns the time spent by the given number of threads, each of them
+ * adding and processing patients in turn.
+ */
+double timeThreads(ConcurrentPatientQueue& queue, int threads, int opsPerThread) {
+    setRandomSeed(106);
+
+    // start with some patients, so processing threads find work
+    for (int i = 0; i < 10000; i++) {
+        queue.newPatient("waiting" + integerToString(i), randomInteger(1, 10000));
+    }
+
+    // names and priorities are made before the clock starts
+    vector<Vector<string>> names(threads);
+    vector<Vector<int>> priorities(threads);
+    for (int t = 0; t < threads; t++) {
+        for (int i = 0; i < opsPerThread / 2; i++) {
+            names[t].add("desk" + integerToString(t) + "-" + integerToString(i));
+            priorities[t].add(randomInteger(1, 10000));
+        }
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(thread([&queue, &names, &priorities, t]() {
+            for (int i = 0; i < names[t].size(); i++) {
+                queue.newPatient(names[t][i], priorities[t][i]);
+                try {
+                    queue.processPatient();
+                } catch (const string&) {
+                    // another thread took the last patient
+                }
+            }
+        }));
+    }
+    for (thread& worker: workers) {
+        worker.join();
+    }
+    return elapsedMs(start);
+}
+
+/*
+ * Runs the ward scheduler with one worker thread per ward, first without
+ * stealing and then with several inversion bounds. Skew percent of the
+ * patients are admitted to ward 0, the others are spread evenly.
+ */
+void benchWards(int threads, int count, int skew) {
+    setRandomSeed(106);
+    Vector<int> wardOf;
+    for (int i = 0; i < count; i++) {
+        wardOf.add(randomChance(skew / 100.0) ? 0 : randomInteger(0, threads - 1));
+    }
+
+    cout << count << " patients in " << threads << " wards, "
+         << skew << "% admitted to ward 0:" << endl;
+    timeWards(threads, WardScheduler::NO_STEALING, wardOf, "no stealing");
+    int bounds[] = {0, 10, 100};
+    for (int maxInversion: bounds) {
+        timeWards(threads, maxInversion, wardOf, "inversion <= " + integerToString(maxInversion));
+    }
+}
+
+// Returns the given percentile of the sorted latencies, 0 if there are none
+static double percentile(const vector<double>& sorted, int percent) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    return sorted[(sorted.size() - 1) * percent / 100];
+}
+
+/*
+ * Times one run of the ward scheduler and prints throughput, the latency
+ * from admission to treatment of local and of stolen patients, the number
+ * of steals and the largest priority inversion seen.
+ * Every worker admits the patients of its ward, taking the next patient
+ * after every two admissions, and then takes patients until it finds none.
+ */
+void timeWards(int threads, int maxInversion, const Vector<int>& wardOf, const string& label) {
+    WardScheduler scheduler(threads, maxInversion);
+    int count = wardOf.size();
+
+    // names are patient numbers, to find the admission time of a patient
+    setRandomSeed(106);
+    vector<Vector<string>> names(threads);
+    vector<Vector<int>> priorities(threads);
+    for (int i = 0; i < count; i++) {
+        names[wardOf[i]].add(integerToString(i));
+        priorities[wardOf[i]].add(randomInteger(1, MAX_PRIORITY));
+    }
+    vector<chrono::steady_clock::time_point> admitted(count);
+    vector<vector<double>> local(threads);
+    vector<vector<double>> stolen(threads);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(thread([&, t]() {
+            string name;
+            int priority;
+            int fromWard;
+            int i = 0;
+            while (true) {
+                // two admissions per treatment, so patients queue up
+                for (int k = 0; k < 2 && i < names[t].size(); k++, i++) {
+                    admitted[stringToInteger(names[t][i])] = chrono::steady_clock::now();
+                    scheduler.newPatient(t, names[t][i], priorities[t][i]);
+                }
+                if (!scheduler.nextPatient(t, name, priority, fromWard)) {
+                    // patients admitted later go to wards with busy workers
+                    if (i == names[t].size()) {
+                        break;
+                    }
+                    continue;
+                }
+                chrono::duration<double, micro> waited =
+                        chrono::steady_clock::now() - admitted[stringToInteger(name)];
+                (fromWard == t ? local[t] : stolen[t]).push_back(waited.count());
+
+                // treating the patient takes a moment
+                volatile int work = 0;
+                for (int spin = 0; spin < 200; spin++) {
+                    work = work + spin;
+                }
+            }
+        }));
+    }
+    for (thread& worker: workers) {
+        worker.join();
+    }
+    double ms = elapsedMs(start);
+
+    vector<double> localAll;
+    vector<double> stolenAll;
+    for (int t = 0; t < threads; t++) {
+        localAll.insert(localAll.end(), local[t].begin(), local[t].end());
+        stolenAll.insert(stolenAll.end(), stolen[t].begin(), stolen[t].end());
+    }
+    sort(localAll.begin(), localAll.end());
+    sort(stolenAll.begin(), stolenAll.end());
+
+    printResult(label, ms, count);
+    cout << setw(WIDTH) << left << "" << setprecision(1)
+         << "local p50/p99 " << percentile(localAll, 50) << "/" << percentile(localAll, 99) << " us, "
+         << "stolen p50/p99 " << percentile(stolenAll, 50) << "/" << percentile(stolenAll, 99) << " us, "
+         << scheduler.steals() << " steals, inversion " << scheduler.largestInversion() << endl;
+}
+
+/*
+ * Churns a linked list queue that keeps count patients waiting:
+ * every round processes one patient and adds a new one.
+ * Prints time and the allocation metrics of its node pool.
+ */
+void benchNodePool(int count, int rounds) {
+    setRandomSeed(106);
+
+    Vector<string> names;
+    Vector<int> priorities;
+    for (int i = 0; i < count + rounds; i++) {
+        names.add("p" + integerToString(i));
+        priorities.add(randomInteger(1, 1000));
+    }
+
+    LinkedListPatientQueue queue;
+    long long allocationsBefore = allocationCount();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    for (int i = 0; i < count; i++) {
+        queue.newPatient(names[i], priorities[i]);
+    }
+    for (int i = count; i < count + rounds; i++) {
+        queue.processPatient();
+        queue.newPatient(names[i], priorities[i]);
+    }
+    queue.clear();
+
+    double ms = elapsedMs(start);
+    long long allocations = allocationCount() - allocationsBefore;
+    const PatientNodePool& pool = queue.nodePool();
+
+    printResult("linked list churn", ms, count + 2 * rounds);
+    cout << setw(WIDTH) << left << "all allocations" << allocations << endl;
+    cout << setw(WIDTH) << left << "node requests" << pool.nodeRequests() << endl;
+    cout << setw(WIDTH) << left << "nodes reused" << pool.nodesReused() << endl;
+    cout << setw(WIDTH) << left << "chunks allocated" << pool.chunkAllocations() << endl;
+    cout << setw(WIDTH) << left << "peak nodes in use" << pool.peakNodesInUse() << endl;
+}
+
+/*
+ * Compares taking k patients at a time with processPatients(k) and
+ * looking at them with peekTop(k) against k calls of processPatient().
+ */
+void benchTopK(int count, int k, int rounds, const string& queues) {
+    for (char letter: queues) {
+        string name;
+        PatientQueue* queue = newQueue(letter, name);
+        if (queue == nullptr) {
+            continue;
+        }
+        printResult(name + ", looped", timeTopK(*queue, count, k, rounds, 'L'), k * rounds);
+        queue->clear();
+        printResult(name + ", batch", timeTopK(*queue, count, k, rounds, 'B'), k * rounds);
+        queue->clear();
+        printResult(name + ", peek", timeTopK(*queue, count, k, rounds, 'P'), k * rounds);
+        delete queue;
+    }
+}
+
+/*
+ * Fills the queue with count patients, then takes k patients in every
+ * round and adds k new ones, so the queue keeps its size.
+ * Mode L loops processPatient(), B calls processPatients(k) and
+ * P calls peekTop(k) instead of taking the patients.
+ * Returns the time spent taking or peeking only.
+ */
+double timeTopK(PatientQueue& queue, int count, int k, int rounds, char mode) {
+    setRandomSeed(106); // the same workload for every queue
+
+    Vector<string> names;
+    Vector<int> priorities;
+    for (int i = 0; i < count + k * rounds; i++) {
+        names.add("patient" + integerToString(i));
+        priorities.add(randomInteger(1, MAX_PRIORITY));
+    }
+    for (int i = 0; i < count; i++) {
+        queue.newPatient(names[i], priorities[i]);
+    }
+
+    double ms = 0;
+    int next = count;
+    for (int round = 0; round < rounds; round++) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        if (mode == 'L') {
+            // collect the names like processPatients() does
+            Vector<string> processed;
+            for (int i = 0; i < k && !queue.isEmpty(); i++) {
+                processed.add(string());
+                processed[processed.size() - 1] = queue.processPatient();
+            }
+        } else if (mode == 'B') {
+            queue.processPatients(k);
+        } else {
+            queue.peekTop(k);
+        }
+        ms += elapsedMs(start);
+
+        if (mode != 'P') {
+            for (int i = 0; i < k; i++, next++) {
+                queue.newPatient(names[next], priorities[next]);
+            }
+        }
+    }
+    return ms;
+}
+
+/*
+ * Times the usual desk round, a look at the front followed by
+ * processing and a new arrival, for small to medium queues.
+ */
+void benchFront(int rounds, const string& queues) {
+    int sizes[] = {16, 64, 256, 1024, 4096};
+    for (int count: sizes) {
+        for (char letter: queues) {
+            string name;
+            PatientQueue* queue = newQueue(letter, name);
+            if (queue == nullptr) {
+                continue;
+            }
+            printResult(name + ", " + integerToString(count) + " waiting",
+                        timeFront(*queue, count, rounds), rounds);
+            delete queue;
+        }
+    }
+}
+
+/*
+ * Fills the queue with count patients and returns the time spent in
+ * rounds of frontName(), frontPriority(), processPatient() and newPatient().
+ */
+template <typename Queue>
+double timeFront(Queue& queue, int count, int rounds) {
+    setRandomSeed(106); // the same workload for every queue
+
+    Vector<string> names;
+    Vector<int> priorities;
+    for (int i = 0; i < count + rounds; i++) {
+        names.add("patient" + integerToString(i));
+        priorities.add(randomInteger(1, MAX_PRIORITY));
+    }
+    for (int i = 0; i < count; i++) {
+        queue.newPatient(names[i], priorities[i]);
+    }
+
+    long long check = 0; // so the calls are not optimized away
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = count; i < count + rounds; i++) {
+        check += queue.frontName().size() + queue.frontPriority();
+        queue.processPatient();
+        queue.newPatient(names[i], priorities[i]);
+    }
+    double ms = elapsedMs(start);
+
+    if (check == 0) {
+        cout << "no patients" << endl;
+    }
+    return ms;
+}
+
+/*
+ * Adds count patients to a journaled queue and times reopening it,
+ * once by replaying the whole journal and once from a snapshot.
+ * The files are written to the current directory and removed at the end.
+ */
+void benchJournal(int count, int groupSize) {
+    const string path = "hospitalbench-journal";
+    remove((path + ".snapshot").c_str());
+    remove((path + ".journal").c_str());
+
+    setRandomSeed(106);
+    Vector<string> names;
+    Vector<int> priorities;
+    for (int i = 0; i < count; i++) {
+        names.add("waiting-patient-" + integerToString(i));
+        priorities.add(randomInteger(1, MAX_PRIORITY));
+    }
+
+    HeapPatientQueue plain(true);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+        plain.newPatient(names[i], priorities[i]);
+    }
+    printResult("heap, in memory", elapsedMs(start), count);
+
+    {
+        JournaledPatientQueue queue(path, groupSize, 0);
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < count; i++) {
+            queue.newPatient(names[i], priorities[i]);
+        }
+        queue.sync();
+        printResult("journaled, group " + integerToString(groupSize), elapsedMs(start), count);
+    }
+
+    {
+        JournaledPatientQueue queue(path, groupSize, 0);
+        printResult("recovery from journal", queue.recoveryMs(), queue.recoveredFromJournal());
+        start = chrono::steady_clock::now();
+        queue.snapshot();
+        printResult("writing snapshot", elapsedMs(start), count);
+    }
+
+    {
+        JournaledPatientQueue queue(path, groupSize, 0);
+        printResult("recovery from snapshot", queue.recoveryMs(), count);
+    }
+
+    remove((path + ".snapshot").c_str());
+    remove((path + ".journal").c_str());
+}
+
+/*
+ * Compares the queue template called through PatientQueue references,
+ * as all other benchmarks do, with the same queues called through their
+ * concrete types, where the members can be inlined into the loops.
+ */
+void benchGeneric(int count, int rounds) {
+    cout << "new and process " << count << " patients, then "
+         << rounds << " front/process rounds with 64 waiting:" << endl;
+    benchDevirtualized<HeapPatientQueue>('H', count, rounds);
+    benchDevirtualized<DaryHeapPatientQueue<4>>('D', count, rounds);
+    benchDevirtualized<NameOrderedPatientQueue>('G', count, rounds);
+    benchDevirtualized<ArrivalOrderedPatientQueue>('A', count, rounds);
+}
+
+/*
+ * Runs the new/process and the front benchmarks on the queue for the
+ * given letter, once through a PatientQueue pointer and once directly.
+ */
+template <typename Queue>
+void benchDevirtualized(char letter, int count, int rounds) {
+    string name;
+    PatientQueue* queue = newQueue(letter, name);
+    printResult(name + ", interface", timeNewAndProcess(*queue, count), 2 * count);
+    delete queue;
+
+    Queue direct;
+    printResult(name + ", direct", timeNewAndProcess(direct, count), 2 * count);
+
+    queue = newQueue(letter, name);
+    printResult(name + ", interface", timeFront(*queue, 64, rounds), rounds);
+    delete queue;
+
+    direct.clear();
+    printResult(name + ", direct", timeFront(direct, 64, rounds), rounds);
+}
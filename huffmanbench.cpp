@@ -0,0 +1,749 @@
+/*
+ * huffmanbench.cpp
+ *
+ * This file contains the main program for timing the Huffman encoding
+ * functions of encoding.cpp on a file, usually a text corpus. It prints
+ * only the measured times and throughputs, in MB of original data per second.
+ *
+ * Without arguments it shows a menu. The benchmarks can also run in batch
+ * mode, for example from a script comparing two builds:
+ *
+ *   huffmanbench decode FILE [ROUNDS]        times the table decoder against
+ *                                            the tree walk
+ *   huffmanbench encode FILE [ROUNDS]        times the packed encoder against
+ *                                            map lookups and writeBit()
+ *   huffmanbench count FILE [ROUNDS]         times the frequency table against
+ *                                            map updates per byte
+ *   huffmanbench header FILE [ROUNDS]        compares header size and
+ *                                            decompression time of the code
+ *                                            length and frequency headers
+ *   huffmanbench blocks FILE [ROUNDS] [KIB]  times the block container, with
+ *                                            blocks of KIB KiB, against one
+ *                                            table for the whole file
+ *   huffmanbench stream FILE [ROUNDS] [KIB]  times the one pass stream
+ *                                            container, with chunks of KIB
+ *                                            KiB, against compress()
+ *   huffmanbench files FILE [ROUNDS]         times compressFile() and
+ *                                            decompressFile() on the mapped
+ *                                            file against the stream functions;
+ *                                            writes FILE.bench.* and removes them
+ *   huffmanbench limit FILE [ROUNDS]         compares size and decompression
+ *                                            speed of codes limited to 11 and
+ *                                            15 bits and of unlimited codes
+ *   huffmanbench tree FILE [ROUNDS]          times building the encoding tree
+ *                                            in one array against new per node
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "console.h"
+#include "bitstream.h"
+#include "simpio.h"
+#include "strlib.h"
+#include "vector.h"
+#include "encoding.h"
+#include "encodingmodes.h"
+#include "huffmantables.h"
+#include "FlatHuffmanTree.h"
+#include "HuffmanNode.h"
+
+using namespace std;
+
+static const int WIDTH = 28;  // column width for result output
+
+// function prototype declarations
+int batch(const Vector<string>& args);
+bool readFile(const string& file, string& contents);
+static double elapsedMs(chrono::steady_clock::time_point start);
+static void printResult(const string& label, double ms, long long bytes);
+void benchDecode(const string& contents, int rounds);
+void decodeTreeWalk(ibitstream& input, HuffmanNode* encodingTree, ostream& output);
+void benchEncode(const string& contents, int rounds);
+void encodeBitwise(istream& input, const Map<int, string>& encodingMap, obitstream& output);
+void benchCount(const string& contents, int rounds);
+Map<int, int> countWithMap(istream& input);
+void benchHeader(const string& contents, int rounds);
+string compressFirstVersion(const string& contents);
+void benchBlocks(const string& contents, int rounds, size_t blockSize);
+void benchStream(const string& contents, int rounds, size_t chunkSize);
+void benchFiles(const string& file, const string& contents, int rounds);
+void benchLimit(const string& contents, int rounds);
+string compressLimited(const string& contents, int maxLength);
+void benchTree(const string& contents, int rounds);
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        Vector<string> args;
+        for (int i = 1; i < argc; i++) {
+            args.add(argv[i]);
+        }
+        return batch(args);
+    }
+
+    cout << "CS 106B Huffman Encoding Benchmarks" << endl;
+    cout << "===================================" << endl;
+
+    while (true) {
+        cout << endl;
+        string choice = toUpperCase(trim(getLine("D)ecode, E)ncode, C)ount, H)eader, B)locks, S)tream, F)iles, L)imit, T)ree, Q)uit?")));
+        if (choice.empty() || choice == "Q") {
+            break;
+        }
+
+        string file = trim(getLine("Input file? "));
+        string contents;
+        if (!readFile(file, contents)) {
+            cout << "Can not open the file." << endl;
+            continue;
+        }
+        int rounds = getInteger("How many rounds? ");
+        if (choice == "D") {
+            benchDecode(contents, rounds);
+        } else if (choice == "E") {
+            benchEncode(contents, rounds);
+        } else if (choice == "C") {
+            benchCount(contents, rounds);
+        } else if (choice == "H") {
+            benchHeader(contents, rounds);
+        } else if (choice == "B") {
+            benchBlocks(contents, rounds, getInteger("Block size in KiB? ") * size_t(1024));
+        } else if (choice == "S") {
+            benchStream(contents, rounds, getInteger("Chunk size in KiB? ") * size_t(1024));
+        } else if (choice == "F") {
+            benchFiles(file, contents, rounds);
+        } else if (choice == "L") {
+            benchLimit(contents, rounds);
+        } else if (choice == "T") {
+            benchTree(contents, rounds);
+        }
+    }
+
+    cout << endl;
+    cout << "Exiting." << endl;
+    return 0;
+}
+
+/*
+ * Runs the command given on the command line, see the top of this file.
+ * Returns exit code of the program.
+ */
+int batch(const Vector<string>& args) {
+    string command = args[0];
+    if (args.size() < 2) {
+        cerr << "Usage: huffmanbench [decode FILE [ROUNDS] | encode FILE [ROUNDS]"
+             << " | count FILE [ROUNDS] | header FILE [ROUNDS]"
+             << " | blocks FILE [ROUNDS] [KIB] | stream FILE [ROUNDS] [KIB]"
+             << " | files FILE [ROUNDS] | limit FILE [ROUNDS] | tree FILE [ROUNDS]]" << endl;
+        return 1;
+    }
+
+    string contents;
+    if (!readFile(args[1], contents)) {
+        cerr << "Can not open " << args[1] << endl;
+        return 1;
+    }
+    int rounds = args.size() >= 3 ? stringToInteger(args[2]) : 5;
+
+    if (command == "decode") {
+        benchDecode(contents, rounds);
+        return 0;
+    } else if (command == "encode") {
+        benchEncode(contents, rounds);
+        return 0;
+    } else if (command == "count") {
+        benchCount(contents, rounds);
+        return 0;
+    } else if (command == "header") {
+        benchHeader(contents, rounds);
+        return 0;
+    } else if (command == "blocks") {
+        size_t blockSize = args.size() >= 4 ? stringToInteger(args[3]) * size_t(1024) : DEFAULT_BLOCK_SIZE;
+        benchBlocks(contents, rounds, blockSize);
+        return 0;
+    } else if (command == "stream") {
+        size_t chunkSize = args.size() >= 4 ? stringToInteger(args[3]) * size_t(1024) : DEFAULT_BLOCK_SIZE;
+        benchStream(contents, rounds, chunkSize);
+        return 0;
+    } else if (command == "files") {
+        benchFiles(args[1], contents, rounds);
+        return 0;
+    } else if (command == "limit") {
+        benchLimit(contents, rounds);
+        return 0;
+    } else if (command == "tree") {
+        benchTree(contents, rounds);
+        return 0;
+    }
+
+    cerr << "Usage: huffmanbench [decode FILE [ROUNDS] | encode FILE [ROUNDS]"
+             << " | count FILE [ROUNDS] | header FILE [ROUNDS]"
+             << " | blocks FILE [ROUNDS] [KIB] | stream FILE [ROUNDS] [KIB]"
+             << " | files FILE [ROUNDS] | limit FILE [ROUNDS] | tree FILE [ROUNDS]]" << endl;
+    return 1;
+}
+
+// Reads the whole file into contents. Returns false if it can not be opened
+bool readFile(const string& file, string& contents) {
+    ifstream input(file.c_str(), ios::binary);
+    if (!input) {
+        return false;
+    }
+    stringstream buffer;
+    buffer << input.rdbuf();
+    contents = buffer.str();
+    return true;
+}
+
+// Returns milliseconds passed since start
+static double elapsedMs(chrono::steady_clock::time_point start) {
+    chrono::duration<double, milli> ms = chrono::steady_clock::now() - start;
+    return ms.count();
+}
+
+// Prints one line of results: time per round and MB of original data per second
+static void printResult(const string& label, double ms, long long bytes) {
+    cout << setw(WIDTH) << left << label
+         << setw(12) << right << fixed << setprecision(2) << ms << " ms"
+         << setw(12) << right << (bytes / ms / 1000.0) << " MB/s" << endl;
+}
+
+/*
+ * Compresses the contents once, with the frequency table in the header,
+ * then decompresses them with the decode tables of decodeData() and with
+ * the bit by bit tree walk it replaced.
+ * Checks that both give back the contents.
+ */
+void benchDecode(const string& contents, int rounds) {
+    string data = compressFirstVersion(contents);
+    cout << contents.size() << " bytes, " << data.size() << " compressed, "
+         << rounds << " rounds:" << endl;
+
+    double tableMs = 0;
+    double walkMs = 0;
+    bool same = true;
+    for (int round = 0; round < rounds; round++) {
+        istringbitstream tableInput(data);
+        ostringstream tableOutput;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        decompress(tableInput, tableOutput);
+        tableMs += elapsedMs(start);
+
+        // the same steps as decompress(), with the old decoding loop
+        istringbitstream walkInput(data);
+        ostringstream walkOutput;
+        start = chrono::steady_clock::now();
+        Map<int, int> freqTable;
+        walkInput >> freqTable;
+        HuffmanNode* encodingTree = buildEncodingTree(freqTable);
+        decodeTreeWalk(walkInput, encodingTree, walkOutput);
+        freeTree(encodingTree);
+        walkMs += elapsedMs(start);
+
+        same = same && tableOutput.str() == contents && walkOutput.str() == contents;
+    }
+
+    printResult("tree walk", walkMs / rounds, contents.size());
+    printResult("decode tables", tableMs / rounds, contents.size());
+    if (!same) {
+        cout << "The decoded data differ from the input!" << endl;
+    }
+}
+
+/*
+ * Decodes as decodeData() did before the decode tables: reads one bit at
+ * a time and follows the zero or one pointer, until the code of PSEUDO_EOF.
+ */
+void decodeTreeWalk(ibitstream& input, HuffmanNode* encodingTree, ostream& output) {
+    HuffmanNode* curr = encodingTree;
+    if (curr->isLeaf()) {
+        return;
+    }
+    while (true) {
+        int bit = input.readBit();
+        if (bit == 0) {
+            curr = curr->zero;
+        } else if (bit == 1) {
+            curr = curr->one;
+        } else {
+            return;
+        }
+
+        if (curr->isLeaf()) {
+            if (curr->character == PSEUDO_EOF) {
+                return;
+            }
+            output << static_cast<char>(curr->character);
+            curr = encodingTree;
+        }
+    }
+}
+
+/*
+ * Encodes the contents with the packed codes of encodeData() and with the
+ * map lookups and writeBit() calls it replaced, from the same encoding map.
+ * Checks that both write the same bits.
+ */
+void benchEncode(const string& contents, int rounds) {
+    istringstream input(contents);
+    Map<int, int> freqTable = buildFrequencyTable(input);
+    HuffmanNode* encodingTree = buildEncodingTree(freqTable);
+    Map<int, string> encodingMap = buildEncodingMap(encodingTree);
+    freeTree(encodingTree);
+    cout << contents.size() << " bytes, " << rounds << " rounds:" << endl;
+
+    double packedMs = 0;
+    double bitwiseMs = 0;
+    bool same = true;
+    for (int round = 0; round < rounds; round++) {
+        istringstream packedInput(contents);
+        ostringbitstream packedOutput;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        encodeData(packedInput, encodingMap, packedOutput);
+        packedMs += elapsedMs(start);
+
+        istringstream bitwiseInput(contents);
+        ostringbitstream bitwiseOutput;
+        start = chrono::steady_clock::now();
+        encodeBitwise(bitwiseInput, encodingMap, bitwiseOutput);
+        bitwiseMs += elapsedMs(start);
+
+        same = same && packedOutput.str() == bitwiseOutput.str();
+    }
+
+    printResult("map and writeBit", bitwiseMs / rounds, contents.size());
+    printResult("packed codes", packedMs / rounds, contents.size());
+    if (!same) {
+        cout << "The encoded data differ!" << endl;
+    }
+}
+
+/*
+ * Encodes as encodeData() did before the packed codes: looks up the code
+ * string of every character in the map and writes it one bit at a time.
+ */
+void encodeBitwise(istream& input, const Map<int, string>& encodingMap, obitstream& output) {
+    int key;
+    while ((key = input.get()) != EOF) {
+        for (char bit: encodingMap.get(key)) {
+            output.writeBit(bit - '0');
+        }
+    }
+    for (char bit: encodingMap.get(PSEUDO_EOF)) {
+        output.writeBit(bit - '0');
+    }
+}
+
+/*
+ * Builds the frequency table of the contents with buildFrequencyTable()
+ * and with the map update per byte it replaced, and times countBytes()
+ * alone on the contents in memory. Checks that the tables are the same.
+ */
+void benchCount(const string& contents, int rounds) {
+    cout << contents.size() << " bytes, " << rounds << " rounds:" << endl;
+
+    double flatMs = 0;
+    double mapMs = 0;
+    double memoryMs = 0;
+    bool same = true;
+    for (int round = 0; round < rounds; round++) {
+        istringstream flatInput(contents);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        Map<int, int> flat = buildFrequencyTable(flatInput);
+        flatMs += elapsedMs(start);
+
+        istringstream mapInput(contents);
+        start = chrono::steady_clock::now();
+        Map<int, int> perByte = countWithMap(mapInput);
+        mapMs += elapsedMs(start);
+
+        uint64_t counts[256] = {};
+        start = chrono::steady_clock::now();
+        countBytes(contents.data(), contents.size(), counts);
+        memoryMs += elapsedMs(start);
+
+        for (int key = 0; key <= PSEUDO_EOF; key++) {
+            same = same && flat.get(key) == perByte.get(key)
+                   && (key == PSEUDO_EOF || static_cast<int>(counts[key]) == flat.get(key));
+        }
+    }
+
+    printResult("map per byte", mapMs / rounds, contents.size());
+    printResult("flat counts", flatMs / rounds, contents.size());
+    printResult("flat counts in memory", memoryMs / rounds, contents.size());
+    if (!same) {
+        cout << "The frequency tables differ!" << endl;
+    }
+}
+
+/*
+ * Builds the frequency table as buildFrequencyTable() did before the flat
+ * counts: a map lookup and a map update for every byte.
+ */
+Map<int, int> countWithMap(istream& input) {
+    Map<int, int> freqTable;
+    int key;
+    while ((key = input.get()) != EOF) {
+        freqTable.put(key, freqTable.get(key) + 1);
+    }
+    freqTable.put(PSEUDO_EOF, 1);
+    return freqTable;
+}
+
+/*
+ * Compresses the contents as compress() does, with the code lengths in the
+ * header, and as the first version did, with the frequency table, then
+ * times decompress() of both. Small files show the startup cost.
+ */
+void benchHeader(const string& contents, int rounds) {
+    istringstream input(contents);
+    ostringbitstream compressed;
+    compress(input, compressed);
+    string lengthFile = compressed.str();
+    string frequencyFile = compressFirstVersion(contents);
+    cout << contents.size() << " bytes, " << rounds << " rounds:" << endl;
+
+    string labels[] = {"frequency header", "code length header"};
+    string files[] = {frequencyFile, lengthFile};
+    for (int i = 0; i < 2; i++) {
+        double ms = 0;
+        bool same = true;
+        for (int round = 0; round < rounds; round++) {
+            istringbitstream fileInput(files[i]);
+            ostringstream output;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            decompress(fileInput, output);
+            ms += elapsedMs(start);
+            same = same && output.str() == contents;
+        }
+        cout << setw(WIDTH) << left << labels[i] << setw(12) << right << files[i].size() << " bytes"
+             << setw(12) << fixed << setprecision(1) << ms * 1000.0 / rounds << " us" << endl;
+        if (!same) {
+            cout << "The decompressed data differ from the input!" << endl;
+        }
+    }
+}
+
+// Returns the contents compressed as the first version of compress() did
+string compressFirstVersion(const string& contents) {
+    istringstream input(contents);
+    Map<int, int> freqTable = buildFrequencyTable(input);
+    HuffmanNode* encodingTree = buildEncodingTree(freqTable);
+    Map<int, string> encodingMap = buildEncodingMap(encodingTree);
+    freeTree(encodingTree);
+
+    ostringbitstream output;
+    output << freqTable;
+    istringstream data(contents);
+    encodeData(data, encodingMap, output);
+    return output.str();
+}
+
+/*
+ * Compresses the contents with compress() and into a block container, then
+ * decompresses both, and times decompressing one block from the middle of
+ * the container alone. Checks that all give back the contents.
+ */
+void benchBlocks(const string& contents, int rounds, size_t blockSize) {
+    cout << contents.size() << " bytes, blocks of " << blockSize << " bytes, "
+         << rounds << " rounds:" << endl;
+
+    double wholeMs = 0;
+    double blocksMs = 0;
+    double wholeBackMs = 0;
+    double blocksBackMs = 0;
+    double oneBlockMs = 0;
+    string wholeFile;
+    string blockFile;
+    bool same = true;
+    for (int round = 0; round < rounds; round++) {
+        istringstream wholeInput(contents);
+        ostringbitstream wholeOutput;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        compress(wholeInput, wholeOutput);
+        wholeMs += elapsedMs(start);
+        wholeFile = wholeOutput.str();
+
+        istringstream blockInput(contents);
+        ostringstream blockOutput;
+        start = chrono::steady_clock::now();
+        compressBlocks(blockInput, blockOutput, blockSize);
+        blocksMs += elapsedMs(start);
+        blockFile = blockOutput.str();
+
+        istringbitstream wholeBack(wholeFile);
+        ostringstream wholeBackOutput;
+        start = chrono::steady_clock::now();
+        decompress(wholeBack, wholeBackOutput);
+        wholeBackMs += elapsedMs(start);
+
+        istringbitstream blocksBack(blockFile);
+        ostringstream blocksBackOutput;
+        start = chrono::steady_clock::now();
+        decompress(blocksBack, blocksBackOutput);
+        blocksBackMs += elapsedMs(start);
+
+        // skip the magic bytes and the version
+        start = chrono::steady_clock::now();
+        BlockContainer container(blockFile.data() + 4, blockFile.size() - 4);
+        int middle = container.blockCount() / 2;
+        if (container.blockCount() > 0) {
+            string block(container.blockSize(middle), '\0');
+            container.decompressBlock(middle, &block[0]);
+            same = same && block == contents.substr(middle * blockSize, block.size());
+        }
+        oneBlockMs += elapsedMs(start);
+
+        same = same && wholeBackOutput.str() == contents && blocksBackOutput.str() == contents;
+    }
+
+    cout << setw(WIDTH) << left << "one table" << setw(12) << right << wholeFile.size() << " bytes" << endl;
+    cout << setw(WIDTH) << left << "block container" << setw(12) << right << blockFile.size() << " bytes"
+         << setw(12) << fixed << setprecision(2) << 100.0 * blockFile.size() / max<size_t>(wholeFile.size(), 1)
+         << " %" << endl;
+    printResult("compress one table", wholeMs / rounds, contents.size());
+    printResult("compress blocks", blocksMs / rounds, contents.size());
+    printResult("decompress one table", wholeBackMs / rounds, contents.size());
+    printResult("decompress blocks", blocksBackMs / rounds, contents.size());
+    cout << setw(WIDTH) << left << "decompress middle block" << setw(12) << right << fixed
+         << setprecision(1) << oneBlockMs * 1000.0 / rounds << " us" << endl;
+    if (!same) {
+        cout << "The decompressed data differ from the input!" << endl;
+    }
+}
+
+/*
+ * Compresses the contents with compress(), which reads them twice, and
+ * into a stream container in one pass, then decompresses both.
+ * Checks that both give back the contents.
+ */
+void benchStream(const string& contents, int rounds, size_t chunkSize) {
+    cout << contents.size() << " bytes, chunks of " << chunkSize << " bytes, "
+         << rounds << " rounds:" << endl;
+
+    double wholeMs = 0;
+    double streamMs = 0;
+    double wholeBackMs = 0;
+    double streamBackMs = 0;
+    string wholeFile;
+    string streamFile;
+    bool same = true;
+    for (int round = 0; round < rounds; round++) {
+        istringstream wholeInput(contents);
+        ostringbitstream wholeOutput;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        compress(wholeInput, wholeOutput);
+        wholeMs += elapsedMs(start);
+        wholeFile = wholeOutput.str();
+
+        istringstream streamInput(contents);
+        ostringstream streamOutput;
+        start = chrono::steady_clock::now();
+        compressStream(streamInput, streamOutput, chunkSize);
+        streamMs += elapsedMs(start);
+        streamFile = streamOutput.str();
+
+        istringbitstream wholeBack(wholeFile);
+        ostringstream wholeBackOutput;
+        start = chrono::steady_clock::now();
+        decompress(wholeBack, wholeBackOutput);
+        wholeBackMs += elapsedMs(start);
+
+        istringbitstream streamBack(streamFile);
+        ostringstream streamBackOutput;
+        start = chrono::steady_clock::now();
+        decompress(streamBack, streamBackOutput);
+        streamBackMs += elapsedMs(start);
+
+        same = same && wholeBackOutput.str() == contents && streamBackOutput.str() == contents;
+    }
+
+    cout << setw(WIDTH) << left << "two passes" << setw(12) << right << wholeFile.size() << " bytes" << endl;
+    cout << setw(WIDTH) << left << "stream container" << setw(12) << right << streamFile.size() << " bytes"
+         << setw(12) << fixed << setprecision(2) << 100.0 * streamFile.size() / max<size_t>(wholeFile.size(), 1)
+         << " %" << endl;
+    printResult("compress two passes", wholeMs / rounds, contents.size());
+    printResult("compress stream", streamMs / rounds, contents.size());
+    printResult("decompress two passes", wholeBackMs / rounds, contents.size());
+    printResult("decompress stream", streamBackMs / rounds, contents.size());
+    if (!same) {
+        cout << "The decompressed data differ from the input!" << endl;
+    }
+}
+
+/*
+ * Compresses the file with compress() from a file stream and with
+ * compressFile(), then decompresses both outputs with decompress() and
+ * decompressFile(). Also decompresses a block container with
+ * decompressFile(), which decodes it straight into the mapped output.
+ * Checks that all give back the contents.
+ */
+void benchFiles(const string& file, const string& contents, int rounds) {
+    cout << contents.size() << " bytes, " << rounds << " rounds:" << endl;
+    string streamFile = file + ".bench.huf";
+    string mappedFile = file + ".bench.map.huf";
+    string blockFile = file + ".bench.blocks.huf";
+    string outFile = file + ".bench.out";
+
+    istringstream blockInput(contents);
+    ofstream blockOutput(blockFile.c_str(), ios::binary);
+    compressBlocks(blockInput, blockOutput);
+    blockOutput.close();
+
+    double ms[5] = {};
+    bool same = true;
+    for (int round = 0; round < rounds; round++) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        {
+            ifstream input(file.c_str(), ios::binary);
+            ofbitstream output(streamFile);
+            compress(input, output);
+        }
+        ms[0] += elapsedMs(start);
+
+        start = chrono::steady_clock::now();
+        compressFile(file, mappedFile);
+        ms[1] += elapsedMs(start);
+
+        string back;
+        start = chrono::steady_clock::now();
+        {
+            ifbitstream input(streamFile);
+            ofstream output(outFile.c_str(), ios::binary);
+            decompress(input, output);
+        }
+        ms[2] += elapsedMs(start);
+        same = same && readFile(outFile, back) && back == contents;
+
+        start = chrono::steady_clock::now();
+        decompressFile(mappedFile, outFile);
+        ms[3] += elapsedMs(start);
+        same = same && readFile(outFile, back) && back == contents;
+
+        start = chrono::steady_clock::now();
+        decompressFile(blockFile, outFile);
+        ms[4] += elapsedMs(start);
+        same = same && readFile(outFile, back) && back == contents;
+    }
+
+    string labels[] = {"compress", "compressFile", "decompress", "decompressFile",
+                       "decompressFile of blocks"};
+    for (int i = 0; i < 5; i++) {
+        printResult(labels[i], ms[i] / rounds, contents.size());
+    }
+    if (!same) {
+        cout << "The decompressed data differ from the input!" << endl;
+    }
+
+    remove(streamFile.c_str());
+    remove(mappedFile.c_str());
+    remove(blockFile.c_str());
+    remove(outFile.c_str());
+}
+
+/*
+ * Compresses the contents with codes of at most 11 and 15 bits and with
+ * the unlimited codes of the encoding tree, then times decompress() of
+ * each. Codes of up to 11 bits, DecodeTable::ROOT_BITS, decode in one probe.
+ */
+void benchLimit(const string& contents, int rounds) {
+    cout << contents.size() << " bytes, " << rounds << " rounds:" << endl;
+
+    string labels[] = {"unlimited", "15 bits", "11 bits"};
+    int limits[] = {MAX_CODE_LENGTH, 15, 11};
+    for (int i = 0; i < 3; i++) {
+        string file = compressLimited(contents, limits[i]);
+        double ms = 0;
+        bool same = true;
+        for (int round = 0; round < rounds; round++) {
+            istringbitstream input(file);
+            ostringstream output;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            decompress(input, output);
+            ms += elapsedMs(start);
+            same = same && output.str() == contents;
+        }
+        cout << setw(WIDTH) << left << labels[i] << setw(12) << right << file.size() << " bytes"
+             << setw(12) << fixed << setprecision(2) << ms / rounds << " ms"
+             << setw(12) << (contents.size() / (ms / rounds) / 1000.0) << " MB/s" << endl;
+        if (!same) {
+            cout << "The decompressed data differ from the input!" << endl;
+        }
+    }
+}
+
+// Returns the contents compressed as compress() does, with codes of
+// at most maxLength bits
+string compressLimited(const string& contents, int maxLength) {
+    istringstream input(contents);
+    Map<int, int> freqTable = buildFrequencyTable(input);
+    HuffmanNode* encodingTree = buildEncodingTree(freqTable);
+    int lengths[PSEUDO_EOF + 1];
+    codeLengths(encodingTree, lengths);
+    freeTree(encodingTree);
+    limitCodeLengths(freqTable, maxLength, lengths);
+
+    ostringstream output;
+    output.write(CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC));
+    output.put(static_cast<char>(CANONICAL_CONTAINER));
+    writeCodeLengths(output, lengths);
+    istringstream data(contents);
+    EncodeTable(lengths).encode(data, output);
+    return output.str();
+}
+
+/*
+ * Builds the encoding tree of the contents and its code lengths many times
+ * with buildEncodingTree() and freeTree(), and with FlatHuffmanTree from the
+ * frequency table and from the flat counts. Checks that the lengths are the
+ * same. Prints microseconds per tree, the cost every small file pays.
+ */
+void benchTree(const string& contents, int rounds) {
+    const int BUILDS = 1000;
+    istringstream input(contents);
+    Map<int, int> freqTable = buildFrequencyTable(input);
+    uint64_t counts[256] = {};
+    countBytes(contents.data(), contents.size(), counts);
+    cout << freqTable.size() << " symbols, " << rounds << " rounds of " << BUILDS << " trees:" << endl;
+
+    double ms[3] = {};
+    int lengths[3][PSEUDO_EOF + 1];
+    for (int round = 0; round < rounds; round++) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int i = 0; i < BUILDS; i++) {
+            HuffmanNode* encodingTree = buildEncodingTree(freqTable);
+            codeLengths(encodingTree, lengths[0]);
+            freeTree(encodingTree);
+        }
+        ms[0] += elapsedMs(start);
+
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < BUILDS; i++) {
+            FlatHuffmanTree encodingTree(freqTable);
+            codeLengths(encodingTree.root(), lengths[1]);
+        }
+        ms[1] += elapsedMs(start);
+
+        start = chrono::steady_clock::now();
+        for (int i = 0; i < BUILDS; i++) {
+            FlatHuffmanTree encodingTree(counts);
+            codeLengths(encodingTree.root(), lengths[2]);
+        }
+        ms[2] += elapsedMs(start);
+    }
+
+    string labels[] = {"new per node", "flat from table", "flat from counts"};
+    for (int i = 0; i < 3; i++) {
+        cout << setw(WIDTH) << left << labels[i] << setw(12) << right << fixed << setprecision(2)
+             << ms[i] * 1000.0 / rounds / BUILDS << " us" << endl;
+    }
+    if (!equal(lengths[0], lengths[0] + PSEUDO_EOF + 1, lengths[1])
+            || !equal(lengths[0], lengths[0] + PSEUDO_EOF + 1, lengths[2])) {
+        cout << "The code lengths differ!" << endl;
+    }
+}
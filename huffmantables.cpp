@@ -0,0 +1,665 @@
+/*
+ * huffmantables.cpp
+ *
+ * This file implements the members of the BitReader, DecodeTable, BitWriter
+ * and EncodeTable classes.
+ */
+
+#include "huffmantables.h"
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+// Function prototypes
+static int height(HuffmanNode* node);
+static HuffmanNode* follow(HuffmanNode* node, int bits, int maxLength, int& length);
+static void countRange(const unsigned char* next, const unsigned char* end, uint64_t counts[256]);
+static void setLengths(HuffmanNode* node, int depth, int lengths[]);
+
+// Reads the code lengths from the bytes nextByte() returns, EOF at the end
+template <typename NextByte>
+static void parseCodeLengths(NextByte nextByte, int lengths[PSEUDO_EOF + 1])
+{
+    int previous = 0;
+    int symbol = 0;
+    while (symbol <= PSEUDO_EOF)
+    {
+        int value = nextByte();
+        if (value == EOF)
+            throw string("readCodeLengths: the header ends before all code lengths.");
+
+        if (value < 0x80)
+        {
+            if (value > MAX_CODE_LENGTH)
+                throw string("readCodeLengths: a code length is too long.");
+            lengths[symbol++] = value;
+            previous = value;
+            continue;
+        }
+
+        int run = value - 0x80 + 2;
+        if (symbol + run > PSEUDO_EOF + 1)
+            throw string("readCodeLengths: a run of code lengths is too long.");
+        for (int i = 0; i < run; ++i)
+            lengths[symbol++] = previous;
+    }
+}
+
+void codeLengths(HuffmanNode* encodingTree, int lengths[PSEUDO_EOF + 1])
+{
+    for (int symbol = 0; symbol <= PSEUDO_EOF; ++symbol)
+        lengths[symbol] = 0;
+
+    if (encodingTree != nullptr)
+        setLengths(encodingTree, 0, lengths);
+}
+
+// Package-merge: the lists of every level, from the longest length, hold
+// the symbols and the packages of the pairs of the level below, lightest
+// first. The 2n - 2 lightest items of the last level are the optimal code,
+// each symbol one bit longer for every level where it is taken. Taking the
+// first items of a level takes the lightest symbols and the packages made
+// from the first items of the level below, so only the kind of each item
+// has to be kept to count them.
+void limitCodeLengths(const Map<int, int>& freqTable, int maxLength, int lengths[PSEUDO_EOF + 1])
+{
+    if (maxLength < 1 || maxLength > MAX_CODE_LENGTH)
+        throw string("limitCodeLengths: the limit must be from 1 to 64 bits.");
+    if (*max_element(lengths, lengths + PSEUDO_EOF + 1) <= maxLength)
+        return;
+
+    vector<pair<uint64_t, int>> symbols;
+    for (int symbol: freqTable)
+        symbols.push_back(make_pair(static_cast<uint64_t>(freqTable.get(symbol)), symbol));
+    sort(symbols.begin(), symbols.end());
+    size_t count = symbols.size();
+    if (maxLength < 64 && count > (uint64_t(1) << maxLength))
+        throw string("limitCodeLengths: the limit is too short for all symbols.");
+
+    struct Item {
+        uint64_t weight;
+        bool symbol;
+    };
+    vector<vector<Item>> levels(maxLength);
+    for (int level = 0; level < maxLength; ++level)
+    {
+        // merge the symbols with the packages of the level below
+        vector<Item>& items = levels[level];
+        size_t next = 0;
+        size_t packages = (level == 0) ? 0 : levels[level - 1].size() / 2;
+        for (size_t i = 0; i < packages; ++i)
+        {
+            const vector<Item>& below = levels[level - 1];
+            uint64_t weight = below[2 * i].weight + below[2 * i + 1].weight;
+            while (next < count && symbols[next].first <= weight)
+                items.push_back({symbols[next++].first, true});
+            items.push_back({weight, false});
+        }
+        while (next < count)
+            items.push_back({symbols[next++].first, true});
+    }
+
+    for (int symbol = 0; symbol <= PSEUDO_EOF; ++symbol)
+        lengths[symbol] = 0;
+    size_t take = 2 * count - 2;
+    for (int level = maxLength - 1; level >= 0 && take > 0; --level)
+    {
+        size_t taken = 0;
+        for (size_t i = 0; i < take; ++i)
+        {
+            if (levels[level][i].symbol)
+                ++lengths[symbols[taken++].second];
+        }
+        take = 2 * (take - taken);
+    }
+}
+
+// Counts the codes of every length, gives the first code of each length,
+// then numbers the symbols. Codes are numbers sent highest bit first, so
+// they are reversed into the order of the bit buffers.
+void canonicalCodes(const int lengths[PSEUDO_EOF + 1], uint64_t codes[PSEUDO_EOF + 1])
+{
+    int count[MAX_CODE_LENGTH + 1] = {};
+    for (int symbol = 0; symbol <= PSEUDO_EOF; ++symbol)
+        ++count[lengths[symbol]];
+    count[0] = 0;
+
+    uint64_t next[MAX_CODE_LENGTH + 1];
+    uint64_t code = 0;
+    for (int length = 1; length <= MAX_CODE_LENGTH; ++length)
+    {
+        code = (code + count[length - 1]) << 1;
+        next[length] = code;
+    }
+
+    for (int symbol = 0; symbol <= PSEUDO_EOF; ++symbol)
+    {
+        int length = lengths[symbol];
+        codes[symbol] = 0;
+        if (length == 0)
+            continue;
+
+        uint64_t number = next[length]++;
+        for (int i = 0; i < length; ++i)
+        {
+            if ((number >> (length - 1 - i)) & 1)
+                codes[symbol] |= 1ULL << i;
+        }
+    }
+}
+
+void writeCodeLengths(ostream& output, const int lengths[PSEUDO_EOF + 1])
+{
+    int previous = 0;
+    int symbol = 0;
+    while (symbol <= PSEUDO_EOF)
+    {
+        int length = lengths[symbol];
+        if (length != previous)
+        {
+            output.put(static_cast<char>(length));
+            previous = length;
+            ++symbol;
+            continue;
+        }
+
+        // the same length again: count the run
+        int run = 0;
+        while (symbol + run <= PSEUDO_EOF && lengths[symbol + run] == previous && run < 129)
+            ++run;
+
+        if (run == 1)
+            output.put(static_cast<char>(length));
+        else
+            output.put(static_cast<char>(0x80 + run - 2));
+        symbol += run;
+    }
+}
+
+void readCodeLengths(istream& input, int lengths[PSEUDO_EOF + 1])
+{
+    parseCodeLengths([&input]() { return input.get(); }, lengths);
+}
+
+size_t readCodeLengths(const char* data, size_t size, int lengths[PSEUDO_EOF + 1])
+{
+    size_t used = 0;
+    parseCodeLengths([data, size, &used]() {
+        return (used < size) ? static_cast<unsigned char>(data[used++]) : EOF;
+    }, lengths);
+    return used;
+}
+
+// Constructor. Reads the stream in chunks as the buffer needs them
+BitReader::BitReader(istream& input)
+    : input(&input), chunk(CHUNK), data(nullptr), size(0)
+{
+}
+
+// Constructor. Reads bytes from memory, which must outlive the reader
+BitReader::BitReader(const char* data, size_t size)
+    : input(nullptr), data(reinterpret_cast<const unsigned char*>(data)), size(size)
+{
+}
+
+BitCursor BitReader::begin() const
+{
+    BitCursor cursor;
+    cursor.buffer = 0;
+    cursor.count = 0;
+    cursor.padding = 0;
+    cursor.next = data;
+    cursor.end = data + size;
+    return cursor;
+}
+
+// Adds the input byte by byte, near the end of a chunk or of the input,
+// and reads the next chunk of the stream when needed
+BitCursor BitReader::refillSlowly(BitCursor cursor)
+{
+    while (cursor.count <= 56)
+    {
+        if (cursor.next == cursor.end)
+        {
+            streamsize got = 0;
+            if (input != nullptr)
+            {
+                input->read(reinterpret_cast<char*>(chunk.data()), CHUNK);
+                got = input->gcount();
+            }
+            if (got > 0)
+            {
+                cursor.next = chunk.data();
+                cursor.end = cursor.next + got;
+            }
+            else
+            {
+                cursor.count += 8;
+                cursor.padding += 8;
+                continue;
+            }
+        }
+        cursor.buffer |= static_cast<uint64_t>(*cursor.next++) << cursor.count;
+        cursor.count += 8;
+    }
+    return cursor;
+}
+
+const int DecodeTable::ROOT_BITS;
+
+// Constructor. The root table looks up ROOT_BITS bits, or fewer if no
+// code is that long
+DecodeTable::DecodeTable(HuffmanNode* encodingTree)
+    : rootBits(0), single(false)
+{
+    if (encodingTree == nullptr || encodingTree->isLeaf())
+    {
+        single = true;
+        return;
+    }
+
+    rootBits = min(ROOT_BITS, height(encodingTree));
+    addTable(encodingTree, encodingTree, rootBits);
+}
+
+// Constructor. Builds a tree of the canonical codes in a local array
+// and the tables from it, the same as from an encoding tree
+DecodeTable::DecodeTable(const int lengths[PSEUDO_EOF + 1])
+    : rootBits(0), single(false)
+{
+    uint64_t codes[PSEUDO_EOF + 1];
+    canonicalCodes(lengths, codes);
+
+    // a complete code of n symbols has 2n - 1 nodes,
+    // the array must not move as nodes point into it
+    const string damaged = "DecodeTable: the code lengths do not make a complete code.";
+    vector<HuffmanNode> nodes;
+    nodes.reserve(2 * (PSEUDO_EOF + 1));
+    nodes.push_back(HuffmanNode());
+
+    int symbols = 0;
+    for (int symbol = 0; symbol <= PSEUDO_EOF; ++symbol)
+    {
+        if (lengths[symbol] == 0)
+            continue;
+        ++symbols;
+
+        HuffmanNode* node = &nodes[0];
+        for (int i = 0; i < lengths[symbol]; ++i)
+        {
+            if (node->character != NOT_A_CHAR)
+                throw damaged;
+
+            HuffmanNode*& child = ((codes[symbol] >> i) & 1) ? node->one : node->zero;
+            if (child == nullptr)
+            {
+                if (nodes.size() == nodes.capacity())
+                    throw damaged;
+                nodes.push_back(HuffmanNode());
+                child = &nodes.back();
+            }
+            node = child;
+        }
+
+        if (!node->isLeaf() || node->character != NOT_A_CHAR)
+            throw damaged;
+        node->character = symbol;
+    }
+
+    // only empty input has a single symbol, with a code of no bits
+    if (symbols < 2)
+    {
+        single = true;
+        return;
+    }
+
+    for (const HuffmanNode& node: nodes)
+    {
+        if (node.character == NOT_A_CHAR && (node.zero == nullptr || node.one == nullptr))
+            throw damaged;
+    }
+
+    rootBits = min(ROOT_BITS, height(&nodes[0]));
+    addTable(&nodes[0], &nodes[0], rootBits);
+}
+
+// Adds a table for the codes below node, looking up the given number
+// of bits, and the tables it links to. Where the code of a character
+// leaves room for another whole code from root, the entry holds both.
+// Returns offset of the table in entries.
+int DecodeTable::addTable(HuffmanNode* root, HuffmanNode* node, int bits)
+{
+    int offset = entries.size();
+    entries.resize(offset + (1 << bits));
+
+    for (int i = 0; i < (1 << bits); ++i)
+    {
+        int length;
+        HuffmanNode* curr = follow(node, i, bits, length);
+
+        Entry entry;
+        entry.second = 0;
+        entry.symbols = 1;
+        entry.length = static_cast<unsigned char>(length);
+        entry.subBits = 0;
+        if (curr->isLeaf())
+        {
+            entry.value = curr->character;
+
+            int secondLength;
+            HuffmanNode* next = follow(root, i >> length, bits - length, secondLength);
+            if (curr->character != PSEUDO_EOF && next->isLeaf() && next->character != PSEUDO_EOF)
+            {
+                entry.second = static_cast<unsigned char>(next->character);
+                entry.symbols = 2;
+                entry.length = static_cast<unsigned char>(length + secondLength);
+            }
+        }
+        else
+        {
+            // entries may move while the linked table is added
+            int subBits = min(ROOT_BITS, height(curr));
+            entry.value = addTable(root, curr, subBits);
+            entry.subBits = static_cast<unsigned char>(subBits);
+        }
+        entries[offset + i] = entry;
+    }
+
+    return offset;
+}
+
+// Writes the characters out in chunks
+void DecodeTable::decode(BitReader& reader, ostream& output) const
+{
+    // a tree of a single leaf is only built for empty input
+    if (single)
+        return;
+
+    const size_t SIZE = 1 << 16;
+    vector<char> out(SIZE);
+    BitCursor cursor = reader.begin();
+    bool done = false;
+    while (!done)
+    {
+        size_t used = decodeRun(reader, cursor, out.data(), SIZE, done);
+        output.write(out.data(), used);
+    }
+}
+
+// Decodes the run, then the last character if a probe of two did not fit,
+// then checks that PSEUDO_EOF comes next
+void DecodeTable::decode(BitReader& reader, char* out, size_t size) const
+{
+    const string damaged = "DecodeTable: the data do not decode to the expected size.";
+    if (single)
+    {
+        if (size != 0)
+            throw damaged;
+        return;
+    }
+
+    BitCursor cursor = reader.begin();
+    bool done = false;
+    size_t used = decodeRun(reader, cursor, out, size, done);
+    if (!done && used < size)
+    {
+        const Entry* entry = probe(reader, cursor);
+        if (entry->value == PSEUDO_EOF || entry->symbols != 1)
+            throw damaged;
+        out[used++] = static_cast<char>(entry->value);
+    }
+    if (!done)
+        done = (probe(reader, cursor)->value == PSEUDO_EOF);
+
+    if (!done || used != size || cursor.pastEnd())
+        throw damaged;
+}
+
+// Decodes one or two characters per probe, or takes a few probes for
+// long codes, while two more characters fit in out. Sets done at the code
+// of PSEUDO_EOF or at the end of the input.
+// Returns the number of characters stored.
+size_t DecodeTable::decodeRun(BitReader& reader, BitCursor& cursor, char* out, size_t limit, bool& done) const
+{
+    // the cursor stays in registers while the loop runs
+    BitCursor local = cursor;
+    size_t used = 0;
+    done = false;
+    while (used + 2 <= limit)
+    {
+        const Entry* entry = probe(reader, local);
+
+        // the tree walk would wait for more bits of a truncated input forever
+        if (entry->value == PSEUDO_EOF || local.pastEnd())
+        {
+            done = true;
+            break;
+        }
+
+        out[used] = static_cast<char>(entry->value);
+        out[used + 1] = static_cast<char>(entry->second);
+        used += entry->symbols;
+    }
+
+    cursor = local;
+    return used;
+}
+
+// Constructor. Stores the bits in chunks, a word may reach 8 bytes past one
+BitWriter::BitWriter(ostream& output)
+    : output(&output), chunk(CHUNK + 8)
+{
+}
+
+BitSink BitWriter::begin()
+{
+    BitSink sink;
+    sink.buffer = 0;
+    sink.count = 0;
+    sink.next = chunk.data();
+    sink.end = chunk.data() + CHUNK;
+    return sink;
+}
+
+// Writes the stored bytes of the chunk and starts it again
+BitSink BitWriter::writeChunk(BitSink sink)
+{
+    output->write(reinterpret_cast<const char*>(chunk.data()), sink.next - chunk.data());
+    sink.next = chunk.data();
+    return sink;
+}
+
+void BitWriter::finish(BitSink sink)
+{
+    if (sink.next + 8 > sink.end)
+        sink = writeChunk(sink);
+
+    for (int i = 0; i < sink.count; i += 8)
+        *sink.next++ = static_cast<unsigned char>(sink.buffer >> i);
+
+    writeChunk(sink);
+}
+
+// Constructor. The first character of a code string is the lowest bit
+EncodeTable::EncodeTable(const Map<int, string>& encodingMap)
+{
+    for (int symbol = 0; symbol <= PSEUDO_EOF; ++symbol)
+    {
+        codes[symbol].bits = 0;
+        codes[symbol].length = 0;
+    }
+
+    for (int symbol: encodingMap)
+    {
+        string code = encodingMap.get(symbol);
+        if (code.size() > 64)
+            throw string("EncodeTable: codes longer than 64 bits are not supported.");
+
+        for (size_t i = 0; i < code.size(); ++i)
+        {
+            if (code[i] == '1')
+                codes[symbol].bits |= 1ULL << i;
+        }
+        codes[symbol].length = code.size();
+    }
+}
+
+// Constructor
+EncodeTable::EncodeTable(const int lengths[PSEUDO_EOF + 1])
+{
+    uint64_t bits[PSEUDO_EOF + 1];
+    canonicalCodes(lengths, bits);
+    for (int symbol = 0; symbol <= PSEUDO_EOF; ++symbol)
+    {
+        codes[symbol].bits = bits[symbol];
+        codes[symbol].length = lengths[symbol];
+    }
+}
+
+// Reads the input in chunks and encodes them
+void EncodeTable::encode(istream& input, ostream& output) const
+{
+    BitWriter writer(output);
+    BitSink sink = writer.begin();
+
+    const int SIZE = 1 << 16;
+    vector<char> data(SIZE);
+    while (input)
+    {
+        input.read(data.data(), SIZE);
+        encode(writer, sink, data.data(), input.gcount());
+    }
+
+    encodeSymbol(writer, sink, PSEUDO_EOF);
+    writer.finish(sink);
+}
+
+void EncodeTable::encode(BitWriter& writer, BitSink& sink, const char* data, size_t size) const
+{
+    // the sink stays in registers while the loop runs
+    BitSink local = sink;
+    const unsigned char* next = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* end = next + size;
+    while (next != end)
+    {
+        const Code& code = codes[*next++];
+        writer.write(local, code.bits, code.length);
+    }
+    sink = local;
+}
+
+// Counts on several threads if the input is long and there are cores
+// for them, each thread on its own part and into its own counts
+void countBytes(const char* data, size_t size, uint64_t counts[256])
+{
+    const unsigned char* next = reinterpret_cast<const unsigned char*>(data);
+    size_t threads = thread::hardware_concurrency();
+    if (size < PARALLEL_COUNT_BYTES || threads < 2)
+    {
+        countRange(next, next + size, counts);
+        return;
+    }
+
+    vector<array<uint64_t, 256>> partial(threads);
+    vector<thread> workers;
+    size_t part = size / threads;
+    for (size_t t = 0; t < threads; ++t)
+    {
+        const unsigned char* begin = next + t * part;
+        const unsigned char* end = (t == threads - 1) ? next + size : begin + part;
+        uint64_t* partCounts = partial[t].data();
+        fill(partCounts, partCounts + 256, 0);
+        workers.push_back(thread([begin, end, partCounts]() {
+            countRange(begin, end, partCounts);
+        }));
+    }
+    for (thread& worker: workers)
+        worker.join();
+
+    for (size_t t = 0; t < threads; ++t)
+    {
+        for (int ch = 0; ch < 256; ++ch)
+            counts[ch] += partial[t][ch];
+    }
+}
+
+Map<int, int> frequencyTable(const uint64_t counts[256])
+{
+    Map<int, int> freqTable;
+    for (int ch = 0; ch < 256; ++ch)
+    {
+        if (counts[ch] != 0)
+            freqTable.put(ch, counts[ch]);
+    }
+    freqTable.put(PSEUDO_EOF, 1);
+    return freqTable;
+}
+
+// Counts into four tables in turn, so an increment does not wait for the
+// one before it when the same byte repeats. The 32-bit counts of a table
+// can not overflow in blocks of 1 GiB.
+static void countRange(const unsigned char* next, const unsigned char* end, uint64_t counts[256])
+{
+    const size_t BLOCK = static_cast<size_t>(1) << 30;
+
+    while (next != end)
+    {
+        const unsigned char* blockEnd = (static_cast<size_t>(end - next) > BLOCK) ? next + BLOCK : end;
+        uint32_t tables[4][256] = {};
+
+        while (blockEnd - next >= 4)
+        {
+            ++tables[0][next[0]];
+            ++tables[1][next[1]];
+            ++tables[2][next[2]];
+            ++tables[3][next[3]];
+            next += 4;
+        }
+        while (next != blockEnd)
+            ++tables[0][*next++];
+
+        for (int ch = 0; ch < 256; ++ch)
+            counts[ch] += static_cast<uint64_t>(tables[0][ch]) + tables[1][ch] + tables[2][ch] + tables[3][ch];
+    }
+}
+
+// Sets the lengths of the leaves below node, which is depth bits deep
+static void setLengths(HuffmanNode* node, int depth, int lengths[])
+{
+    if (node->isLeaf())
+    {
+        if (depth > MAX_CODE_LENGTH)
+            throw string("codeLengths: codes longer than 64 bits are not supported.");
+        lengths[node->character] = depth;
+        return;
+    }
+
+    setLengths(node->zero, depth + 1, lengths);
+    setLengths(node->one, depth + 1, lengths);
+}
+
+// Follows the bits, first bit lowest, from node until a leaf or until
+// maxLength bits are used. Sets length to the bits used.
+// Returns the node reached.
+static HuffmanNode* follow(HuffmanNode* node, int bits, int maxLength, int& length)
+{
+    length = 0;
+    while (!node->isLeaf() && length < maxLength)
+    {
+        node = ((bits >> length) & 1) ? node->one : node->zero;
+        ++length;
+    }
+    return node;
+}
+
+// Returns length of the longest code below node
+static int height(HuffmanNode* node)
+{
+    if (node == nullptr || node->isLeaf())
+        return 0;
+    return 1 + max(height(node->zero), height(node->one));
+}
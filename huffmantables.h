@@ -0,0 +1,303 @@
+/*
+ * huffmantables.h
+ *
+ * This file declares the lookup tables used by encoding.cpp to encode and
+ * decode Huffman codes many bits at a time, instead of one bit per step.
+ *
+ * BitReader fills a buffer of up to 64 bits of the input, in the order
+ * ibitstream reads them: the first bit is the lowest bit of the first byte.
+ * DecodeTable looks up the next ROOT_BITS bits of the buffer and gets the
+ * symbol and the length of its code in one probe, or two characters when
+ * both codes fit in those bits. Longer codes continue in secondary tables,
+ * linked from the entries of their first bits.
+ *
+ * EncodeTable keeps every code as its bits and length, indexed by the
+ * character, and BitWriter appends them to a 64-bit buffer that is stored
+ * to memory a whole word at a time.
+ *
+ * countBytes() counts the characters of the frequency table in a flat array.
+ *
+ * Compressed files may store the length of every code instead of the
+ * frequency table. The codes are then the canonical codes of those lengths:
+ * shorter codes first, codes of the same length in the order of their
+ * symbols, each one the code before it plus one. Both tables can be built
+ * from the lengths alone.
+ */
+
+#ifndef _huffmantables_h
+#define _huffmantables_h
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "HuffmanNode.h"
+#include "map.h"
+
+// Longest code the tables and the code length header support
+const int MAX_CODE_LENGTH = 64;
+
+// Sets the length of the code of every symbol, the characters and
+// PSEUDO_EOF, from the encoding tree; 0 for symbols not in the tree.
+// Throws string exception if a code is longer than MAX_CODE_LENGTH.
+void codeLengths(HuffmanNode* encodingTree, int lengths[PSEUDO_EOF + 1]);
+
+// Longest code compress() and the compressors of encodingmodes.h write.
+// Codes of up to ROOT_BITS bits decode in one probe, longer ones in two.
+const int CODE_LENGTH_LIMIT = 15;
+
+// Shortens the lengths set by codeLengths() from the frequency table to
+// the lengths of the best code without codes longer than maxLength, if
+// a code is longer. Throws string exception if maxLength is not from 1 to
+// MAX_CODE_LENGTH or too short for all symbols of the table.
+void limitCodeLengths(const Map<int, int>& freqTable, int maxLength, int lengths[PSEUDO_EOF + 1]);
+
+// Sets the canonical code of every symbol with a length, first bit lowest
+void canonicalCodes(const int lengths[PSEUDO_EOF + 1], uint64_t codes[PSEUDO_EOF + 1]);
+
+// Writes the lengths of all symbols in symbol order, one byte per length
+// below 0x80. A byte from 0x80 repeats the length before it, which is 0
+// at the start, another 2 to 129 times.
+void writeCodeLengths(std::ostream& output, const int lengths[PSEUDO_EOF + 1]);
+
+// Reads the lengths written by writeCodeLengths().
+// Throws string exception if they are damaged.
+void readCodeLengths(std::istream& input, int lengths[PSEUDO_EOF + 1]);
+
+// Reads the lengths from the bytes in memory.
+// Returns the number of bytes they take.
+size_t readCodeLengths(const char* data, size_t size, int lengths[PSEUDO_EOF + 1]);
+
+/*
+ * The position of a decoder in its input: a buffer of up to 64 bits and the
+ * bytes that are not in it yet. Decoders keep it in a local variable, which
+ * the compiler can keep in registers while characters are stored.
+ */
+struct BitCursor {
+    uint64_t buffer;
+    int count;                  // bits in the buffer
+    int padding;                // zero bits added past the end of the input
+    const unsigned char* next;
+    const unsigned char* end;
+
+    // Returns true if more bits were consumed than the input has
+    bool pastEnd() const
+    {
+        return count < padding;
+    }
+};
+
+class BitReader {
+public:
+    // Reads the stream from its current position, which must be the
+    // first bit of a byte
+    explicit BitReader(std::istream& input);
+
+    // Reads the bytes in memory
+    BitReader(const char* data, size_t size);
+
+    // Returns the cursor at the start of the input
+    BitCursor begin() const;
+
+    // Adds bytes of the input to the buffer of the cursor until it holds
+    // at least 57 bits; past the end of the input it adds zero bits
+    void refill(BitCursor& cursor)
+    {
+        if (cursor.end - cursor.next >= 8)
+        {
+            // add the next 8 bytes, of which the whole ones that fit count;
+            // the rest are the same bits the next refill adds again
+            const unsigned char* next = cursor.next;
+            uint64_t word = static_cast<uint64_t>(next[0]) | static_cast<uint64_t>(next[1]) << 8
+                          | static_cast<uint64_t>(next[2]) << 16 | static_cast<uint64_t>(next[3]) << 24
+                          | static_cast<uint64_t>(next[4]) << 32 | static_cast<uint64_t>(next[5]) << 40
+                          | static_cast<uint64_t>(next[6]) << 48 | static_cast<uint64_t>(next[7]) << 56;
+            cursor.buffer |= word << cursor.count;
+            cursor.next += (63 - cursor.count) >> 3;
+            cursor.count |= 56;
+            return;
+        }
+
+        cursor = refillSlowly(cursor);
+    }
+
+private:
+    static const int CHUNK = 1 << 16;
+
+    std::istream* input;            // nullptr for bytes in memory
+    std::vector<unsigned char> chunk;
+    const unsigned char* data;      // bytes in memory
+    size_t size;
+
+    BitCursor refillSlowly(BitCursor cursor);
+};
+
+class DecodeTable {
+public:
+    static const int ROOT_BITS = 11;    // bits looked up in the first probe
+
+    // Builds the tables from the encoding tree, which may be nullptr
+    explicit DecodeTable(HuffmanNode* encodingTree);
+
+    // Builds the tables of the canonical codes of the lengths.
+    // Throws string exception if the lengths do not make a complete code.
+    explicit DecodeTable(const int lengths[PSEUDO_EOF + 1]);
+
+    // Writes the decoded characters to output, until the code of
+    // PSEUDO_EOF or the end of the input
+    void decode(BitReader& reader, std::ostream& output) const;
+
+    // Decodes exactly size characters into out, then the code of PSEUDO_EOF.
+    // Throws string exception if the input does not decode to that.
+    void decode(BitReader& reader, char* out, size_t size) const;
+
+private:
+    // One or two symbols with the total length of their codes, or a link
+    // to the secondary table of the codes that begin with length bits
+    struct Entry {
+        int value;              // first symbol, or offset of the linked table
+        unsigned char second;   // character after the first one, if symbols is 2
+        unsigned char symbols;  // characters decoded by this probe, 1 or 2
+        unsigned char length;   // bits consumed by this probe
+        unsigned char subBits;  // bits looked up in the linked table, 0 for symbols
+    };
+
+    std::vector<Entry> entries;
+    int rootBits;
+    bool single;                // the tree is one leaf, codes have no bits
+
+    int addTable(HuffmanNode* root, HuffmanNode* node, int bits);
+    size_t decodeRun(BitReader& reader, BitCursor& cursor, char* out, size_t limit, bool& done) const;
+
+    // Looks up the next code, through the linked tables if it is long,
+    // and consumes its bits. Returns the entry of its symbols.
+    const Entry* probe(BitReader& reader, BitCursor& cursor) const
+    {
+        reader.refill(cursor);
+        const Entry* entry = &entries[cursor.buffer & ((1U << rootBits) - 1)];
+        while (entry->subBits != 0)
+        {
+            cursor.buffer >>= entry->length;
+            cursor.count -= entry->length;
+            reader.refill(cursor);
+            entry = &entries[entry->value + (cursor.buffer & ((1U << entry->subBits) - 1))];
+        }
+        cursor.buffer >>= entry->length;
+        cursor.count -= entry->length;
+        return entry;
+    }
+};
+
+/*
+ * The position of an encoder in its output: a buffer of bits not stored
+ * yet and the free bytes of the chunk after the stored ones. Encoders keep
+ * it in a local variable, like decoders keep their BitCursor.
+ */
+struct BitSink {
+    uint64_t buffer;
+    int count;                  // bits in the buffer
+    unsigned char* next;
+    unsigned char* end;         // last place where a whole word fits
+};
+
+class BitWriter {
+public:
+    // Writes to the stream from its current position, as whole bytes
+    explicit BitWriter(std::ostream& output);
+
+    // Returns the sink at the start of an empty chunk
+    BitSink begin();
+
+    // Appends the lowest length bits of bits, first bit lowest
+    void write(BitSink& sink, uint64_t bits, int length)
+    {
+        if (length > 56)
+        {
+            // only very skewed inputs have codes this long
+            write(sink, bits & 0xffffffff, 32);
+            write(sink, bits >> 32, length - 32);
+            return;
+        }
+
+        if (sink.count + length > 64)
+        {
+            if (sink.next > sink.end)
+                sink = writeChunk(sink);
+
+            // store the whole word, keep the bits of the last partial byte
+            uint64_t word = sink.buffer;
+            unsigned char* next = sink.next;
+            next[0] = static_cast<unsigned char>(word);
+            next[1] = static_cast<unsigned char>(word >> 8);
+            next[2] = static_cast<unsigned char>(word >> 16);
+            next[3] = static_cast<unsigned char>(word >> 24);
+            next[4] = static_cast<unsigned char>(word >> 32);
+            next[5] = static_cast<unsigned char>(word >> 40);
+            next[6] = static_cast<unsigned char>(word >> 48);
+            next[7] = static_cast<unsigned char>(word >> 56);
+            int bytes = sink.count >> 3;
+            sink.next += bytes;
+            sink.buffer = (bytes == 8) ? 0 : word >> (8 * bytes);
+            sink.count &= 7;
+        }
+
+        sink.buffer |= bits << sink.count;
+        sink.count += length;
+    }
+
+    // Writes all bits of the sink, the last byte filled up with zero bits
+    void finish(BitSink sink);
+
+private:
+    static const int CHUNK = 1 << 16;
+
+    std::ostream* output;
+    std::vector<unsigned char> chunk;
+
+    BitSink writeChunk(BitSink sink);
+};
+
+class EncodeTable {
+public:
+    // Packs the codes of the encoding map, which are strings of '0' and '1'.
+    // Throws string exception if a code is longer than 64 bits.
+    explicit EncodeTable(const Map<int, std::string>& encodingMap);
+
+    // Packs the canonical codes of the lengths
+    explicit EncodeTable(const int lengths[PSEUDO_EOF + 1]);
+
+    // Writes the codes of the characters read from input until its end,
+    // then the code of PSEUDO_EOF
+    void encode(std::istream& input, std::ostream& output) const;
+
+    // Appends the codes of the characters in memory
+    void encode(BitWriter& writer, BitSink& sink, const char* data, size_t size) const;
+
+    // Appends the code of the symbol, a character or PSEUDO_EOF
+    void encodeSymbol(BitWriter& writer, BitSink& sink, int symbol) const
+    {
+        writer.write(sink, codes[symbol].bits, codes[symbol].length);
+    }
+
+private:
+    // Characters missing from the map have no bits, as encodeData() gave them
+    struct Code {
+        uint64_t bits;          // first bit lowest
+        int length;
+    };
+
+    Code codes[PSEUDO_EOF + 1];
+};
+
+// Inputs at least this long are counted by several threads
+const size_t PARALLEL_COUNT_BYTES = 4 << 20;
+
+// Adds the number of times each byte value occurs in data to counts
+void countBytes(const char* data, size_t size, uint64_t counts[256]);
+
+// Returns the frequency table of the counts, which has the characters
+// that occur and PSEUDO_EOF, as buildFrequencyTable() makes it
+Map<int, int> frequencyTable(const uint64_t counts[256]);
+
+#endif // _huffmantables_h
@@ -0,0 +1,91 @@
+/*
+ * memorystats.cpp
+ *
+ * This file implements the functions from memorystats.h header
+ * by replacing the global operator new and delete.
+ */
+
+#include "memorystats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+// every block starts with its size, padded to keep the data aligned
+static const size_t HEADER_SIZE = alignof(max_align_t);
+
+static atomic<long long> allocations(0);
+static atomic<long long> current(0);
+static atomic<long long> peak(0);
+
+long long allocationCount()
+{
+    return allocations;
+}
+
+long long allocatedBytes()
+{
+    return current;
+}
+
+long long peakBytes()
+{
+    return peak;
+}
+
+void resetPeakBytes()
+{
+    peak.store(current.load());
+}
+
+void *operator new(size_t size)
+{
+    char *block = static_cast<char *>(malloc(size + HEADER_SIZE));
+    if (block == nullptr)
+        throw bad_alloc();
+
+    *reinterpret_cast<size_t *>(block) = size;
+
+    ++allocations;
+    long long now = (current += size);
+    long long top = peak.load();
+    while (now > top && !peak.compare_exchange_weak(top, now))
+    {
+        // another thread changed peak, compare again
+    }
+
+    return block + HEADER_SIZE;
+}
+
+void operator delete(void *data) noexcept
+{
+    if (data == nullptr)
+        return;
+
+    char *block = static_cast<char *>(data) - HEADER_SIZE;
+    current -= *reinterpret_cast<size_t *>(block);
+    free(block);
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete[](void *data) noexcept
+{
+    operator delete(data);
+}
+
+// Sized deletes, called instead of the ones above since C++14
+void operator delete(void *data, size_t) noexcept
+{
+    operator delete(data);
+}
+
+void operator delete[](void *data, size_t) noexcept
+{
+    operator delete(data);
+}
@@ -0,0 +1,36 @@
+/*
+ * memorystats.h
+ *
+ * This file declares functions that report heap usage of the program.
+ * memorystats.cpp replaces the global operator new and delete, so every
+ * allocation made with new (including the ones inside strings and
+ * containers) is counted. Link it only into benchmark programs.
+ */
+
+#ifndef _memorystats_h
+#define _memorystats_h
+
+#include <cstddef>
+
+/*
+ * Returns the number of allocations made since the program started.
+ */
+long long allocationCount();
+
+/*
+ * Returns the number of bytes currently allocated.
+ */
+long long allocatedBytes();
+
+/*
+ * Returns the largest number of bytes allocated at once
+ * since the last call to resetPeakBytes().
+ */
+long long peakBytes();
+
+/*
+ * Starts measuring peak usage again from the current usage.
+ */
+void resetPeakBytes();
+
+#endif // _memorystats_h
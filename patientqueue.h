@@ -0,0 +1,134 @@
+/*
+ * CS 106B/X Patient Queue
+ * This file declares the PatientQueue abstract base class that all of the
+ * patient queue implementations extend.
+ */
+
+#ifndef _patientqueue_h
+#define _patientqueue_h
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "vector.h"
+#include "queuestats.h"
+
+/*
+ * One patient to enqueue, used by the bulk newPatients() member.
+ */
+struct PatientRecord {
+    std::string name;
+    int priority;
+};
+
+class PatientQueue {
+public:
+    virtual ~PatientQueue() {}
+    virtual void clear() = 0;
+    virtual std::string frontName() = 0;
+    virtual int frontPriority() = 0;
+    virtual bool isEmpty() = 0;
+    virtual void newPatient(std::string name, int priority) = 0;
+
+    /*
+     * Adds all of the given patients, with the same result as calling
+     * newPatient() for each of them in order.
+     */
+    virtual void newPatients(const Vector<PatientRecord>& patients) = 0;
+
+    virtual std::string processPatient() = 0;
+
+    /*
+     * Removes up to k most urgent patients and returns their names, with the
+     * same result as calling processPatient() k times. Returns fewer names
+     * if the queue runs out of patients instead of throwing.
+     */
+    virtual Vector<std::string> processPatients(int k) = 0;
+
+    /*
+     * Returns up to k most urgent patients in the order processPatients(k)
+     * would return them, without changing the queue.
+     */
+    virtual Vector<PatientRecord> peekTop(int k) = 0;
+
+    virtual void upgradePatient(std::string name, int newPriority) = 0;
+
+    /*
+     * Removes the most urgent patient with the given name, for patients
+     * who leave without being processed.
+     * Throws string exception if there is no patient with that name.
+     */
+    virtual void removePatient(std::string name) = 0;
+
+    virtual std::string toString() = 0;
+
+    /*
+     * Returns the work counted since the queue was created or resetStats()
+     * was called. All counters stay zero when statistics are compiled out,
+     * see queuestats.h.
+     */
+    virtual QueueStats stats() {
+#if PATIENTQUEUE_STATS
+        return counters;
+#else
+        return QueueStats();
+#endif
+    }
+
+    virtual void resetStats() {
+#if PATIENTQUEUE_STATS
+        counters.clear();
+#endif
+    }
+
+protected:
+    // declared in every build, so the layout of the queues does not depend
+    // on PATIENTQUEUE_STATS; only the work of filling it is compiled out
+    QueueStats counters;
+
+    /*
+     * Messages of the string exceptions thrown by the implementations, kept
+     * here so that all of the queues report errors the same way.
+     */
+    static std::string processPatientExceptStr() {
+        return "A patient can not be processed: the queue is empty.";
+    }
+
+    static std::string frontNameExceptStr() {
+        return "Function frontName() failed: the queue is empty.";
+    }
+
+    static std::string frontPriorityExceptStr() {
+        return "Function frontPriority() failed: the queue is empty.";
+    }
+
+    static std::string upgradeWrongPriorityExceptStr(const std::string& name, int newPriority,
+                                                     int currPriority) {
+        std::stringstream str;
+        str << "Function upgradePatient(" << name;
+        str << ", " << newPriority << ") failed: ";
+        str << "current prioritet " << currPriority;
+        str << " is more urgent than new prioritet " << newPriority;
+        str << ".\n";
+        return str.str();
+    }
+
+    static std::string upgradeNoPatientExceptStr(const std::string& name, int newPriority) {
+        std::stringstream str;
+        str << "Function upgradePatient(" << name;
+        str << ", " << newPriority << ") failed: ";
+        str << "there is no patient with that name.\n";
+        return str.str();
+    }
+
+    static std::string removeNoPatientExceptStr(const std::string& name) {
+        std::stringstream str;
+        str << "Function removePatient(" << name << ") failed: ";
+        str << "there is no patient with that name.\n";
+        return str.str();
+    }
+};
+
+std::ostream& operator <<(std::ostream& out, PatientQueue& queue);
+
+#endif // _patientqueue_h
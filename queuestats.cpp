@@ -0,0 +1,190 @@
+/*
+ * queuestats.cpp
+ *
+ * This file implements the members of the Histogram class and of the
+ * QueueStats structure.
+ */
+
+#include "queuestats.h"
+
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+
+// Constructor. Creates empty histogram
+Histogram::Histogram()
+{
+    clear();
+}
+
+// Counts the value in its bucket; negative values count as 0
+void Histogram::add(long long value)
+{
+    if (value < 0)
+        value = 0;
+
+    int i = 0;
+    while (i < BUCKETS - 1 && (value >> i) != 0)
+        ++i;
+
+    ++buckets[i];
+    ++values;
+    sum += value;
+    if (value > largest)
+        largest = value;
+}
+
+// Removes all values
+void Histogram::clear()
+{
+    for (int i = 0; i < BUCKETS; ++i)
+        buckets[i] = 0;
+    values = 0;
+    sum = 0;
+    largest = 0;
+}
+
+// Adds the values of the other histogram
+Histogram& Histogram::operator +=(const Histogram& other)
+{
+    for (int i = 0; i < BUCKETS; ++i)
+        buckets[i] += other.buckets[i];
+    values += other.values;
+    sum += other.sum;
+    if (other.largest > largest)
+        largest = other.largest;
+    return *this;
+}
+
+long long Histogram::count() const
+{
+    return values;
+}
+
+long long Histogram::max() const
+{
+    return largest;
+}
+
+double Histogram::mean() const
+{
+    return values == 0 ? 0.0 : static_cast<double>(sum) / values;
+}
+
+long long Histogram::bucket(int i) const
+{
+    return buckets[i];
+}
+
+// Returns the non-empty buckets in the form of "0:3 1:5 2-3:10 4-7:1"
+string Histogram::toString() const
+{
+    stringstream str;
+
+    for (int i = 0; i < BUCKETS; ++i)
+    {
+        if (buckets[i] == 0)
+            continue;
+
+        if (str.tellp() > 0)
+            str << " ";
+
+        long long low = i == 0 ? 0 : 1LL << (i - 1);
+        long long high = i == 0 ? 0 : (1LL << i) - 1;
+        str << low;
+        if (high > low)
+            str << "-" << high;
+        str << ":" << buckets[i];
+    }
+
+    return str.str();
+}
+
+// Constructor. Creates statistics with all counters at zero
+QueueStats::QueueStats()
+    : waiting(0), running(0)
+{
+    clear();
+}
+
+// Sets all counters to zero; patients still waiting and running timers stay counted
+void QueueStats::clear()
+{
+    comparisons = 0;
+    moves = 0;
+    allocations = 0;
+    bytesReserved = 0;
+    for (int i = 0; i < METHODS; ++i)
+    {
+        calls[i] = 0;
+        nanoseconds[i] = 0;
+    }
+    depth.clear();
+    nameSearch.clear();
+}
+
+// Adds the counters of the other statistics, for queues made of other queues
+QueueStats& QueueStats::operator +=(const QueueStats& other)
+{
+    comparisons += other.comparisons;
+    moves += other.moves;
+    allocations += other.allocations;
+    bytesReserved += other.bytesReserved;
+    for (int i = 0; i < METHODS; ++i)
+    {
+        calls[i] += other.calls[i];
+        nanoseconds[i] += other.nanoseconds[i];
+    }
+    depth += other.depth;
+    nameSearch += other.nameSearch;
+    waiting += other.waiting;
+    return *this;
+}
+
+// Name of the member, such as "newPatient"
+const char* QueueStats::methodName(int method)
+{
+    static const char* const NAMES[METHODS] = {
+        "clear", "frontName", "frontPriority", "newPatient", "newPatients",
+        "processPatient", "processPatients", "peekTop", "upgradePatient", "removePatient",
+        "toString"
+    };
+    return NAMES[method];
+}
+
+// Restores the format of the stream when done, so the caller's
+// later output is not printed fixed or left aligned
+std::ostream& operator <<(std::ostream& out, const QueueStats& stats)
+{
+    ios::fmtflags flags = out.flags();
+    streamsize precision = out.precision();
+
+    out << setw(18) << left << "member" << setw(12) << right << "calls"
+        << setw(14) << "total ms" << setw(12) << "ns/call" << endl;
+    for (int i = 0; i < QueueStats::METHODS; ++i)
+    {
+        if (stats.calls[i] == 0)
+            continue;
+        out << setw(18) << left << QueueStats::methodName(i)
+            << setw(12) << right << stats.calls[i]
+            << setw(14) << fixed << setprecision(3) << stats.nanoseconds[i] / 1e6
+            << setw(12) << setprecision(0) << static_cast<double>(stats.nanoseconds[i]) / stats.calls[i]
+            << endl;
+    }
+
+    out << "comparisons: " << stats.comparisons << endl;
+    out << "moves: " << stats.moves << endl;
+    out << "allocations: " << stats.allocations
+        << " (" << stats.bytesReserved << " bytes)" << endl;
+    out << "depth: " << stats.depth.count() << " samples, mean "
+        << setprecision(1) << stats.depth.mean() << ", max " << stats.depth.max() << endl;
+    out << "  " << stats.depth.toString() << endl;
+    out << "name search: " << stats.nameSearch.count() << " searches, mean "
+        << setprecision(1) << stats.nameSearch.mean() << ", max " << stats.nameSearch.max() << endl;
+    out << "  " << stats.nameSearch.toString() << endl;
+
+    out.flags(flags);
+    out.precision(precision);
+    return out;
+}
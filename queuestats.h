@@ -0,0 +1,193 @@
+/*
+ * queuestats.h
+ *
+ * This file declares the QueueStats structure, in which a patient queue
+ * counts the work it does: comparisons, element moves, allocations, time
+ * spent in every public member, the depth of the queue and how far
+ * upgradePatient() and removePatient() had to search for a name.
+ *
+ * The queues fill it through the STATS_ macros below. Statistics are
+ * compiled in when PATIENTQUEUE_STATS is 1, which is the default unless
+ * NDEBUG is defined; in release builds the macros expand to nothing.
+ * The counters member of PatientQueue is declared either way, so files
+ * built with and without NDEBUG agree on the layout of every queue.
+ * Only the outermost public member is counted and timed: when
+ * processPatients() calls processPatient(), the time and the work of the
+ * inner calls belong to processPatients(), so times never overlap.
+ * A queue's statistics are not thread-safe.
+ */
+
+#ifndef _queuestats_h
+#define _queuestats_h
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef PATIENTQUEUE_STATS
+#ifdef NDEBUG
+#define PATIENTQUEUE_STATS 0
+#else
+#define PATIENTQUEUE_STATS 1
+#endif
+#endif
+
+/*
+ * Histogram with power of two buckets: bucket 0 counts the value 0,
+ * bucket i counts values from 2^(i-1) to 2^i - 1.
+ */
+class Histogram {
+public:
+    static const int BUCKETS = 32;
+
+    Histogram();
+    void add(long long value);
+    void clear();
+    Histogram& operator +=(const Histogram& other);
+
+    long long count() const;  // values added
+    long long max() const;    // largest value added
+    double mean() const;
+    long long bucket(int i) const;
+
+    // Returns the non-empty buckets in the form of "0:3 1:5 2-3:10 4-7:1"
+    std::string toString() const;
+
+private:
+    long long buckets[BUCKETS];
+    long long values;
+    long long sum;
+    long long largest;
+};
+
+struct QueueStats {
+    // the timed members of PatientQueue, in the order they are reported;
+    // isEmpty() is left out, timing it would cost more than the call
+    enum Method {
+        CLEAR, FRONT_NAME, FRONT_PRIORITY, NEW_PATIENT, NEW_PATIENTS,
+        PROCESS_PATIENT, PROCESS_PATIENTS, PEEK_TOP, UPGRADE_PATIENT, REMOVE_PATIENT,
+        TO_STRING, METHODS
+    };
+
+    long long comparisons;   // of two patients or priorities
+    long long moves;         // patients copied, moved or swapped within the queue
+    long long allocations;   // blocks of storage allocated by the queue
+    long long bytesReserved; // bytes of storage allocated by the queue
+    long long calls[METHODS];
+    long long nanoseconds[METHODS];
+    Histogram depth;         // patients waiting when a new one arrives
+    Histogram nameSearch;    // patients looked at to find a name to upgrade or remove
+    long long waiting;       // patients in queues that do not count them,
+                             // kept by clear() for the depth histogram
+    int running;             // timed members running, nested calls are not timed
+
+    QueueStats();
+    void clear();
+    QueueStats& operator +=(const QueueStats& other);
+
+    // Counts the storage a vector allocated since it had the given capacity;
+    // containers that do not tell their capacity are not counted
+    template <typename T>
+    void grew(const std::vector<T>& storage, size_t oldCapacity) {
+        if (storage.capacity() > oldCapacity) {
+            ++allocations;
+            bytesReserved += (storage.capacity() - oldCapacity) * sizeof(T);
+        }
+    }
+
+    template <typename Storage>
+    void grew(const Storage&, size_t) {}
+
+    template <typename T>
+    static size_t capacityOf(const std::vector<T>& storage) {
+        return storage.capacity();
+    }
+
+    template <typename Storage>
+    static size_t capacityOf(const Storage&) {
+        return 0;
+    }
+
+    // Name of the member, such as "newPatient"
+    static const char* methodName(int method);
+
+    /*
+     * Measures one call of a public member from its construction to
+     * its destruction, so calls that throw are counted too. Calls made
+     * while another member of the same queue is timed are left out.
+     */
+    class Timer {
+    public:
+        Timer(QueueStats& stats, Method method)
+            : stats(stats), method(method), outermost(stats.running++ == 0) {
+            if (outermost)
+                start = std::chrono::steady_clock::now();
+        }
+        ~Timer() {
+            --stats.running;
+            if (!outermost)
+                return;
+            std::chrono::nanoseconds ns = std::chrono::steady_clock::now() - start;
+            ++stats.calls[method];
+            stats.nanoseconds[method] += ns.count();
+        }
+
+    private:
+        QueueStats& stats;
+        Method method;
+        bool outermost;
+        std::chrono::steady_clock::time_point start;
+    };
+};
+
+/*
+ * Prints a report of the statistics: a line per member that was called,
+ * the counters and both histograms.
+ */
+std::ostream& operator <<(std::ostream& out, const QueueStats& stats);
+
+/*
+ * Macros for the implementations, which keep their QueueStats in the
+ * counters member inherited from PatientQueue.
+ */
+#if PATIENTQUEUE_STATS
+#define STATS_TIME(method) QueueStats::Timer statsTimer(counters, QueueStats::method)
+#define STATS_COMPARE() (++counters.comparisons)
+#define STATS_COMPARES(n) (counters.comparisons += (n))
+#define STATS_MOVE() (++counters.moves)
+#define STATS_MOVES(n) (counters.moves += (n))
+#define STATS_ALLOC(bytes) (++counters.allocations, counters.bytesReserved += (bytes))
+#define STATS_DEPTH(n) counters.depth.add(n)
+// for queues that do not count their patients
+#define STATS_ARRIVE() counters.depth.add(counters.waiting++)
+#define STATS_LEAVE(n) (counters.waiting -= (n))
+#define STATS_LEAVE_ALL() (counters.waiting = 0)
+#define STATS_SEARCH(n) counters.nameSearch.add(n)
+// runs the code, counting what it makes the vector allocate
+#define STATS_GROWTH(storage, code) \
+    do { \
+        size_t statsCapacity = QueueStats::capacityOf(storage); \
+        code; \
+        counters.grew((storage), statsCapacity); \
+    } while (0)
+#else
+#define STATS_TIME(method) ((void) 0)
+#define STATS_COMPARE() ((void) 0)
+#define STATS_COMPARES(n) ((void) 0)
+#define STATS_MOVE() ((void) 0)
+#define STATS_MOVES(n) ((void) 0)
+#define STATS_ALLOC(bytes) ((void) 0)
+#define STATS_DEPTH(n) ((void) 0)
+#define STATS_ARRIVE() ((void) 0)
+#define STATS_LEAVE(n) ((void) 0)
+#define STATS_LEAVE_ALL() ((void) 0)
+#define STATS_SEARCH(n) ((void) 0)
+#define STATS_GROWTH(storage, code) \
+    do { \
+        code; \
+    } while (0)
+#endif
+
+#endif // _queuestats_h
@@ -0,0 +1,307 @@
+/*
+ * workload.cpp
+ *
+ * This file implements functions from workload.h header.
+ */
+
+#include "workload.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <sstream>
+#include <tuple>
+#include <vector>
+#include "memorystats.h"
+#include "random.h"
+#include "strlib.h"
+
+using namespace std;
+
+const string OPERATION_TYPES = "NPUFR";
+
+// Function prototypes
+static LatencyStats summarize(vector<long long>& latencies, long long allocations);
+static void printLine(ostream& output, const string& queueName, const string& op,
+                      const LatencyStats& stats, const string& totals);
+
+// Reads a workload, one operation per line
+Vector<Operation> loadWorkload(istream& input)
+{
+    Vector<Operation> workload;
+    string line;
+    int lineNumber = 0;
+
+    while (getline(input, line))
+    {
+        ++lineNumber;
+        line = trim(line);
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        istringstream tokens(line);
+        Operation op;
+        op.priority = 0;
+        tokens >> op.type;
+        op.type = toupper(op.type);
+
+        bool ok = OPERATION_TYPES.find(op.type) != string::npos;
+        if (ok && (op.type == 'N' || op.type == 'U'))
+            ok = static_cast<bool>(tokens >> op.name >> op.priority);
+        else if (ok && op.type == 'R')
+            ok = static_cast<bool>(tokens >> op.name);
+
+        if (!ok)
+        {
+            string error = "loadWorkload() error: bad operation on line "
+                    + integerToString(lineNumber) + ": " + line;
+            throw error;
+        }
+
+        workload.add(op);
+    }
+
+    return workload;
+}
+
+// Writes the workload in the format read by loadWorkload()
+void saveWorkload(const Vector<Operation>& workload, ostream& output)
+{
+    for (const auto &op: workload)
+    {
+        output << op.type;
+        if (op.type == 'N' || op.type == 'U')
+            output << " " << op.name << " " << op.priority;
+        else if (op.type == 'R')
+            output << " " << op.name;
+        output << "\n";
+    }
+}
+
+// Returns a random mix of about 40% new, 30% process, 20% upgrade
+// and 10% front operations, with removePercent removals taken out first.
+// The generator keeps its own copy of the queue, so processing, upgrades
+// and removals only happen to patients who are still waiting.
+Vector<Operation> generateWorkload(int count, int maxPriority, int seed, int removePercent, TieBreak ties)
+{
+    setRandomSeed(seed);
+
+    Vector<Operation> workload;
+    // waiting patients by priority, then by arrival (always 0 when ties go by name), then by name
+    set<tuple<int, int, string>> waiting;
+    vector<string> names;      // names of waiting patients, for random upgrades
+    map<string, int> position; // name -> index in names
+    map<string, int> current;  // name -> priority
+    map<string, int> arrival;  // name -> order of arrival or last upgrade
+    int patients = 0;
+    int arrivals = 0;
+
+    // the place of a waiting patient in the queue
+    auto key = [&](const string& name) {
+        return make_tuple(current[name], arrival[name], name);
+    };
+
+    // counts an arrival or upgrade when ties go by arrival
+    auto arrive = [&](const string& name) {
+        arrival[name] = ties == TIES_BY_ARRIVAL ? ++arrivals : 0;
+        waiting.insert(key(name));
+    };
+
+    // forgets a patient who leaves the queue
+    auto leave = [&](string name) {
+        waiting.erase(key(name));
+
+        // swap-remove the patient from names
+        int index = position[name];
+        names[index] = names.back();
+        position[names[index]] = index;
+        names.pop_back();
+        position.erase(name);
+        current.erase(name);
+        arrival.erase(name);
+    };
+
+    for (int i = 0; i < count; i++)
+    {
+        Operation op;
+        op.priority = 0;
+
+        // no extra random numbers without removals, so old mixes stay the same
+        if (removePercent > 0 && !waiting.empty() && randomInteger(1, 100) <= removePercent)
+        {
+            op.type = 'R';
+            op.name = names[randomInteger(0, names.size() - 1)];
+            leave(op.name);
+            workload.add(op);
+            continue;
+        }
+
+        int dice = randomInteger(1, 100);
+        if (dice <= 30 && !waiting.empty())
+        {
+            op.type = 'P';
+            leave(get<2>(*waiting.begin()));
+        }
+        else if (dice <= 50 && !waiting.empty())
+        {
+            op.type = 'U';
+            op.name = names[randomInteger(0, names.size() - 1)];
+            op.priority = current[op.name] - randomInteger(1, 3);
+
+            waiting.erase(key(op.name));
+            current[op.name] = op.priority;
+            arrive(op.name);
+        }
+        else if (dice <= 60 && !waiting.empty())
+        {
+            op.type = 'F';
+        }
+        else
+        {
+            op.type = 'N';
+            // longer than the short string buffer, like most full names
+            op.name = "waiting-patient-" + integerToString(patients++);
+            op.priority = randomInteger(1, maxPriority);
+
+            position[op.name] = names.size();
+            names.push_back(op.name);
+            current[op.name] = op.priority;
+            arrive(op.name);
+        }
+
+        workload.add(op);
+    }
+
+    return workload;
+}
+
+// Runs every operation of the workload against the queue, timing each one
+ReplayResult replayWorkload(PatientQueue& queue, const Vector<Operation>& workload)
+{
+    ReplayResult result;
+    result.operations = workload.size();
+    result.errors = 0;
+
+    // reserve space first, so only the queue allocates while replaying
+    vector<long long> all;
+    vector<long long> byType[5];
+    all.reserve(workload.size());
+    for (int t = 0; t < 5; t++)
+        byType[t].reserve(workload.size());
+
+    long long allocationsByType[5] = {0, 0, 0, 0, 0};
+
+    long long allocationsBefore = allocationCount();
+    long long bytesBefore = allocatedBytes();
+    resetPeakBytes();
+
+    for (const auto &op: workload)
+    {
+        int type = OPERATION_TYPES.find(op.type);
+        long long allocationsAtStart = allocationCount();
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        try
+        {
+            switch (op.type)
+            {
+            case 'N':
+                queue.newPatient(op.name, op.priority);
+                break;
+            case 'P':
+                queue.processPatient();
+                break;
+            case 'U':
+                queue.upgradePatient(op.name, op.priority);
+                break;
+            case 'F':
+                queue.frontName();
+                queue.frontPriority();
+                break;
+            case 'R':
+                queue.removePatient(op.name);
+                break;
+            }
+        }
+        catch (const string &)
+        {
+            ++result.errors;
+        }
+        chrono::nanoseconds ns = chrono::steady_clock::now() - start;
+        allocationsByType[type] += allocationCount() - allocationsAtStart;
+
+        all.push_back(ns.count());
+        byType[type].push_back(ns.count());
+    }
+
+    result.peakBytes = peakBytes() - bytesBefore;
+    result.allocations = allocationCount() - allocationsBefore;
+
+    result.ms = 0;
+    for (long long ns: all)
+        result.ms += ns / 1e6;
+
+    result.all = summarize(all, result.allocations);
+    for (int t = 0; t < 5; t++)
+        result.byType[t] = summarize(byType[t], allocationsByType[t]);
+
+    return result;
+}
+
+// Prints the header line for printReplayResult()
+void printReplayHeader(ostream& output)
+{
+    output << "queue\top\tcount\tallocs_per_op\tp50_ns\tp99_ns\tp999_ns"
+           << "\tms\tops_per_s\terrors\tpeak_kb\tallocations" << endl;
+}
+
+// Prints results of one queue, the totals are on the "all" line only
+void printReplayResult(ostream& output, const string& queueName, const ReplayResult& result)
+{
+    ostringstream totals;
+    totals << fixed;
+    totals.precision(2);
+    totals << result.ms << "\t";
+    totals.precision(0);
+    totals << (result.ms > 0 ? result.operations / result.ms * 1000.0 : 0.0) << "\t"
+           << result.errors << "\t"
+           << result.peakBytes / 1024 << "\t"
+           << result.allocations;
+
+    printLine(output, queueName, "all", result.all, totals.str());
+    for (int t = 0; t < 5; t++)
+        printLine(output, queueName, string(1, OPERATION_TYPES[t]), result.byType[t], "-\t-\t-\t-\t-");
+}
+
+// Sorts latencies and returns their count, allocations per operation and percentiles
+static LatencyStats summarize(vector<long long>& latencies, long long allocations)
+{
+    LatencyStats stats;
+    stats.count = latencies.size();
+    stats.allocationsPerOp = latencies.empty() ? 0.0 : static_cast<double>(allocations) / latencies.size();
+    stats.p50 = stats.p99 = stats.p999 = 0;
+
+    if (latencies.empty())
+        return stats;
+
+    sort(latencies.begin(), latencies.end());
+
+    // index of the smallest latency not exceeded by given fraction of operations
+    size_t size = latencies.size();
+    stats.p50 = latencies[min(size - 1, size * 500 / 1000)];
+    stats.p99 = latencies[min(size - 1, size * 990 / 1000)];
+    stats.p999 = latencies[min(size - 1, size * 999 / 1000)];
+
+    return stats;
+}
+
+// Prints one tab separated line of results
+static void printLine(ostream& output, const string& queueName, const string& op,
+                      const LatencyStats& stats, const string& totals)
+{
+    output << queueName << "\t" << op << "\t" << stats.count << "\t"
+           << fixed << setprecision(2) << stats.allocationsPerOp << "\t"
+           << stats.p50 << "\t" << stats.p99 << "\t" << stats.p999 << "\t"
+           << totals << endl;
+}
@@ -0,0 +1,100 @@
+/*
+ * workload.h
+ *
+ * This file declares functions to load, generate and replay patient queue
+ * workloads without any user interaction. A workload is a list of
+ * operations, one per line in a file, using the letters of the hospital menu:
+ *
+ *   N name priority   newPatient
+ *   P                 processPatient
+ *   U name priority   upgradePatient
+ *   F                 frontName and frontPriority
+ *   R name            removePatient
+ */
+
+#ifndef _workload_h
+#define _workload_h
+
+#include <iostream>
+#include <string>
+#include "patientqueue.h"
+#include "vector.h"
+
+struct Operation {
+    char type;        // 'N', 'P', 'U', 'F' or 'R'
+    std::string name; // for 'N', 'U' and 'R'
+    int priority;     // for 'N' and 'U'
+};
+
+/*
+ * Latency of one kind of operation in a replay, in nanoseconds,
+ * and the allocations it made.
+ */
+struct LatencyStats {
+    int count;
+    double allocationsPerOp; // allocations made by the queue per operation
+    long long p50;
+    long long p99;
+    long long p999;
+};
+
+/*
+ * Results of replaying a workload against one queue.
+ */
+struct ReplayResult {
+    int operations;
+    int errors;             // operations that threw an exception
+    double ms;              // total time spent in the queue
+    long long peakBytes;    // largest heap usage of the queue
+    long long allocations;  // number of allocations made by the queue
+    LatencyStats all;
+    LatencyStats byType[5]; // in the order of OPERATION_TYPES
+};
+
+extern const std::string OPERATION_TYPES; // "NPUFR"
+
+/*
+ * Reads a workload, one operation per line. Empty lines and lines
+ * starting with '#' are skipped.
+ * Throws string exception if a line can not be parsed.
+ */
+Vector<Operation> loadWorkload(std::istream& input);
+
+/*
+ * Writes the workload in the format read by loadWorkload().
+ */
+void saveWorkload(const Vector<Operation>& workload, std::ostream& output);
+
+/*
+ * How a queue orders patients with equal priorities: by name like the heaps,
+ * or by order of arrival like the vector, linked list, skip list and bucket
+ * queues, where an upgrade counts as a new arrival.
+ */
+enum TieBreak { TIES_BY_NAME, TIES_BY_ARRIVAL };
+
+/*
+ * Returns a random mix of the given number of operations with
+ * priorities from 1 to maxPriority. The same seed gives the same mix.
+ * About removePercent of the operations remove a waiting patient;
+ * without removals the mix is the same as before they were added.
+ * The mix only processes and upgrades patients who are still waiting
+ * in queues that break ties as given.
+ */
+Vector<Operation> generateWorkload(int count, int maxPriority, int seed, int removePercent = 0,
+                                   TieBreak ties = TIES_BY_NAME);
+
+/*
+ * Runs every operation of the workload against the queue, timing each one.
+ * The queue should be empty before the call.
+ */
+ReplayResult replayWorkload(PatientQueue& queue, const Vector<Operation>& workload);
+
+/*
+ * Prints a header line and one result line per operation type as
+ * tab separated columns, so outputs of two runs can be diffed or pasted
+ * into a spreadsheet.
+ */
+void printReplayHeader(std::ostream& output);
+void printReplayResult(std::ostream& output, const std::string& queueName, const ReplayResult& result);
+
+#endif // _workload_h